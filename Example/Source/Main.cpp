@@ -1,19 +1,56 @@
+#include "SignatureScanner/ExtendedPatternSignature.hpp"
+#include "SignatureScanner/PatternPair.hpp"
 #include "SignatureScanner/PatternSignature.hpp"
+#include "SignatureScanner/RemoteRegion.hpp"
+#include "SignatureScanner/ScanBatch.hpp"
+#include "SignatureScanner/SegmentedView.hpp"
+#include "SignatureScanner/SignatureGenerator.hpp"
+#include "SignatureScanner/TiledScan.hpp"
+#include "SignatureScanner/TrackedRegion.hpp"
 #include "SignatureScanner/XRefSignature.hpp"
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
 #include <iterator>
+#include <list>
 #include <span>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace SignatureScanner;
 
+// Deterministic pseudo random numbers in [0, bound), so that failures can be reproduced
+static std::uint32_t random_below(std::uint32_t& state, std::uint32_t bound)
+{
+	state = state * 1664525 + 1013904223;
+	// The high bits of a linear congruential generator are the most random ones
+	return static_cast<std::uint32_t>((std::uint64_t{ state } * bound) >> 32);
+}
+
+// Bytes in [0, alphabet)
+static std::vector<std::byte> random_bytes(std::size_t size, std::uint32_t seed, std::uint32_t alphabet = 256)
+{
+	std::vector<std::byte> bytes(size);
+	for (std::byte& byte : bytes)
+		byte = static_cast<std::byte>(random_below(seed, alphabet));
+	return bytes;
+}
+
 static std::uint8_t bytes[]{
 	0x68, 0x74, 0x16, 0xcd, 0xaa, 0xe3, 0x6, 0x95, 0xcb, 0xeb, 0xe7,
 	0x64, 0x1e, 0xbb, 0x5a, 0xf2, 0x65, 0xe5, 0x53, 0x85, 0xb8,
@@ -236,3 +273,853 @@ TEST(XRefPattern, All)
 	EXPECT_EQ(reinterpret_cast<void*>(&*hits[0]), absolute_xref + 8);
 	EXPECT_EQ(reinterpret_cast<void*>(&*hits[1]), relative_xref + 8);
 }
+
+#ifndef SIGNATURESCANNER_OPTIMIZE
+// The optimized translation units walk downwards from the first iterator instead
+TEST(XRefPattern, PrevOnContiguousIterators)
+{
+	init_xref_array();
+
+	// Forward iterators are searched like any other range, the same as a list
+	const PatternSignature pattern = PatternSignature::for_array_of_bytes<"ff e4">();
+	const std::list<std::uint8_t> list(bytes_span.begin(), bytes_span.end());
+	EXPECT_EQ(std::distance(bytes_span.begin(), pattern.prev(bytes_span.begin(), bytes_span.end())), 43);
+	EXPECT_EQ(std::distance(list.begin(), pattern.prev(list.begin(), list.end())), 43);
+
+	for (const std::span<std::uint8_t> ref : { absolute_ref, relative_ref }) {
+		// Reading backwards needs random access
+		const std::deque<std::uint8_t> ref_deque(ref.begin(), ref.end());
+		const auto location = reinterpret_cast<std::uintptr_t>(ref.data());
+		for (const auto& signature : { XRefSignature{ XRefTypes::absolute(), target }, XRefSignature{ XRefTypes::relative(), reinterpret_cast<std::uintptr_t>(&target) } })
+			EXPECT_EQ(std::distance(ref.begin(), signature.prev(ref.begin(), ref.end())), std::distance(ref_deque.begin(), signature.prev(ref_deque.begin(), ref_deque.end(), location)));
+	}
+}
+#endif
+
+static std::uint8_t instructions[64];
+static std::span<std::uint8_t> instructions_span{ instructions };
+
+static void write_reference(std::size_t instruction_offset, std::size_t displacement_offset, std::size_t instruction_length)
+{
+	auto next_instruction = reinterpret_cast<std::uintptr_t>(instructions + instruction_offset + instruction_length);
+	auto displacement = static_cast<std::int32_t>(reinterpret_cast<std::uintptr_t>(&target) - next_instruction);
+	std::memcpy(instructions + instruction_offset + displacement_offset, &displacement, sizeof(std::int32_t));
+}
+
+static void init_instruction_array()
+{
+	std::memset(instructions, 0x90, sizeof(instructions));
+
+	// call target
+	instructions[8] = 0xE8;
+	write_reference(8, 1, 5);
+
+	// lea rax, [rip + target]
+	instructions[20] = 0x48;
+	instructions[21] = 0x8D;
+	instructions[22] = 0x05;
+	write_reference(20, 3, 7);
+
+	// cmp byte ptr [rip + target], 0x42
+	instructions[40] = 0x80;
+	instructions[41] = 0x3D;
+	instructions[46] = 0x42;
+	write_reference(40, 2, 7);
+
+	// Not an instruction, but a valid rel32 if the instruction length is guessed as 4
+	write_reference(54, 0, 4);
+}
+
+TEST(XRefPattern, InstructionRelativeForwards)
+{
+	init_instruction_array();
+
+	auto signature = XRefSignature{ XRefTypes::instruction_relative(), reinterpret_cast<std::uintptr_t>(&target) };
+	auto hit = signature.next(instructions_span.begin(), instructions_span.end());
+
+	EXPECT_NE(hit, instructions_span.end());
+	const std::size_t offset = std::distance(instructions_span.begin(), hit);
+	EXPECT_EQ(offset, 8);
+}
+
+TEST(XRefPattern, InstructionRelativeBackwards)
+{
+	init_instruction_array();
+
+	auto signature = XRefSignature{ XRefTypes::instruction_relative(), reinterpret_cast<std::uintptr_t>(&target) };
+	auto hit = signature.prev(instructions_span.rbegin(), instructions_span.rend());
+
+	EXPECT_NE(hit, instructions_span.rend());
+	const std::size_t offset = std::distance(instructions_span.rbegin(), hit);
+	EXPECT_EQ(offset, 23);
+}
+
+TEST(XRefPattern, InstructionRelativeAll)
+{
+	init_instruction_array();
+
+	auto instruction_sig = XRefSignature{ XRefTypes::instruction_relative(), reinterpret_cast<std::uintptr_t>(&target) };
+	std::vector<decltype(instructions_span)::iterator> hits;
+	instruction_sig.all(instructions_span.begin(), instructions_span.end(), std::back_inserter(hits));
+
+	EXPECT_EQ(hits.size(), 3);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[0]), 8);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[1]), 21);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[2]), 40);
+
+	// Guessing the instruction length misses the cmp and finds the false positive
+	auto relative_sig = XRefSignature{ XRefTypes::relative(), reinterpret_cast<std::uintptr_t>(&target) };
+	hits.clear();
+	relative_sig.all(instructions_span.begin(), instructions_span.end(), std::back_inserter(hits));
+
+	EXPECT_EQ(hits.size(), 3);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[0]), 9);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[1]), 23);
+	EXPECT_EQ(std::distance(instructions_span.begin(), hits[2]), 54);
+}
+
+TEST(XRefPattern, InstructionRelativeOperandSizePrefix)
+{
+	static std::uint8_t prefixed[64];
+	std::memset(prefixed, 0x90, sizeof(prefixed));
+	// Writes the instruction starting at offset (including its prefixes), the displacement always follows the opcode and the ModRM byte
+	const auto write_instruction = [](std::size_t offset, std::initializer_list<std::uint8_t> prefixes_and_opcode, std::size_t immediate_size) {
+		std::ranges::copy(prefixes_and_opcode, prefixed + offset);
+		const std::size_t displacement_offset = offset + prefixes_and_opcode.size();
+		const std::size_t instruction_end = displacement_offset + sizeof(std::int32_t) + immediate_size;
+		auto displacement = static_cast<std::int32_t>(reinterpret_cast<std::uintptr_t>(&target) - reinterpret_cast<std::uintptr_t>(prefixed + instruction_end));
+		std::memcpy(prefixed + displacement_offset, &displacement, sizeof(std::int32_t));
+		std::memset(prefixed + displacement_offset + sizeof(std::int32_t), 0x12, immediate_size);
+	};
+
+	write_instruction(2, { 0x66, 0xC7, 0x05 }, 2); // mov word ptr [rip + target], 0x1212
+	write_instruction(12, { 0x66, 0x81, 0x3D }, 2); // cmp word ptr [rip + target], 0x1212
+	write_instruction(22, { 0xC7, 0x05 }, 4); // mov dword ptr [rip + target], 0x12121212
+	write_instruction(34, { 0x81, 0x3D }, 4); // cmp dword ptr [rip + target], 0x12121212
+	write_instruction(46, { 0x48, 0xC7, 0x05 }, 4); // mov qword ptr [rip + target], 0x12121212
+
+	// Prefixed or not, the match is at the opcode
+	const std::vector<std::ptrdiff_t> expected{ 3, 13, 22, 34, 47 };
+
+	auto signature = XRefSignature{ XRefTypes::instruction_relative(), reinterpret_cast<std::uintptr_t>(&target) };
+	std::vector<std::uint8_t*> hits;
+	signature.all(std::begin(prefixed), std::end(prefixed), std::back_inserter(hits));
+
+	std::vector<std::ptrdiff_t> offsets;
+	for (auto* hit : hits)
+		offsets.push_back(hit - prefixed);
+	EXPECT_EQ(offsets, expected);
+
+	// The generic path decodes the same
+	const std::list<std::uint8_t> list{ std::begin(prefixed), std::end(prefixed) };
+	std::vector<std::list<std::uint8_t>::const_iterator> list_hits;
+	signature.all(list.begin(), list.end(), std::back_inserter(list_hits), reinterpret_cast<std::uintptr_t>(prefixed));
+
+	std::vector<std::ptrdiff_t> list_offsets;
+	for (auto hit : list_hits)
+		list_offsets.push_back(std::distance(list.begin(), hit));
+	EXPECT_EQ(list_offsets, expected);
+
+	// So does the reverse search
+	auto last = signature.prev(std::rbegin(prefixed), std::rend(prefixed));
+	EXPECT_EQ(&*last, prefixed + expected.back());
+	auto second_to_last = signature.prev(std::next(last), std::rend(prefixed));
+	EXPECT_EQ(&*second_to_last, prefixed + expected[expected.size() - 2]);
+}
+
+TEST(BytePattern, ToString)
+{
+	const PatternSignature signature = PatternSignature::for_array_of_bytes<"E8 ? ? ?? ? 0f 1F">();
+
+	EXPECT_EQ(signature.to_string(), "E8 ? ? ? ? 0F 1F");
+	EXPECT_EQ(PatternSignature::for_array_of_bytes(signature.to_string()).get_elements(), signature.get_elements());
+}
+
+static std::vector<std::byte> generate_module()
+{
+	// Few distinct values, so that short signatures are rarely unique
+	std::vector<std::byte> module = random_bytes(4096, 0x13371337, 8);
+	std::copy_n(module.begin() + 500, 200, module.begin() + 3500);
+
+	// call rel32, the operand must not end up in the signature
+	module[100] = std::byte{ 0xE8 };
+	return module;
+}
+
+TEST(SignatureGenerator, Unique)
+{
+	const std::vector<std::byte> module = generate_module();
+	const SignatureGenerator generator{ module };
+
+	for (std::size_t offset : { 0, 97, 1000, 2047, 2900, 4000 }) {
+		auto signature = generator.generate(module.data() + offset);
+		ASSERT_TRUE(signature.has_value());
+
+		std::vector<std::vector<std::byte>::const_iterator> hits;
+		signature->all(module.cbegin(), module.cend(), std::back_inserter(hits));
+		EXPECT_EQ(hits.size(), 1);
+		EXPECT_EQ(std::distance(module.cbegin(), hits[0]), offset);
+
+		// Dropping the last byte has to make the signature ambiguous, otherwise it wasn't the shortest one
+		std::vector<PatternElement> shorter = signature->get_elements();
+		shorter.pop_back();
+		while (!shorter.empty() && !shorter.back().has_value())
+			shorter.pop_back();
+		hits.clear();
+		PatternSignature{ std::move(shorter) }.all(module.cbegin(), module.cend(), std::back_inserter(hits));
+		EXPECT_GT(hits.size(), 1);
+	}
+}
+
+TEST(SignatureGenerator, MasksRelativeOperands)
+{
+	std::vector<std::byte> module = generate_module();
+	// Another call, so that the opcode alone is not unique
+	module[200] = std::byte{ 0xE8 };
+	const SignatureGenerator generator{ module, { 104 } };
+
+	auto signature = generator.generate(module.data() + 100);
+	ASSERT_TRUE(signature.has_value());
+	// The operand of the call and the relocation right behind it
+	EXPECT_TRUE(signature->to_string().starts_with("E8 ? ? ? ? ? ? ? ? ? ? ? 0"));
+}
+
+TEST(SignatureGenerator, NotUnique)
+{
+	const std::vector<std::byte> module = generate_module();
+	const SignatureGenerator generator{ module };
+
+	// This part is repeated later on, there is no way to tell them apart
+	EXPECT_FALSE(generator.generate(module.data() + 550).has_value());
+	EXPECT_FALSE(generator.generate(module.data() + module.size()).has_value());
+}
+
+TEST(ModuleIndex, SameAsLinearScan)
+{
+	std::vector<std::byte> module = random_bytes(64 * 1024, 0xDEADBEEF);
+
+	const std::array<std::byte, 6> needle{ std::byte{ 0x13 }, std::byte{ 0x37 }, std::byte{ 0xCA }, std::byte{ 0xFE }, std::byte{ 0xBA }, std::byte{ 0xBE } };
+	// Inside of a block, across a block boundary and at the very end
+	for (std::size_t offset : { std::size_t{ 100 }, 3 * ModuleIndex::BLOCK_SIZE - 3, 9 * ModuleIndex::BLOCK_SIZE + 5, module.size() - needle.size() })
+		std::ranges::copy(needle, module.begin() + static_cast<std::ptrdiff_t>(offset));
+
+	const ModuleIndex index{ module };
+
+	for (const auto* pattern : { "13 37 CA FE BA BE", "37 ? FE BA", "CA ? BA", "DE AD BE EF" }) {
+		const PatternSignature signature = PatternSignature::for_array_of_bytes(pattern);
+
+		std::vector<std::vector<std::byte>::iterator> linear_hits;
+		std::vector<std::vector<std::byte>::iterator> indexed_hits;
+		signature.all(module.begin(), module.end(), std::back_inserter(linear_hits));
+		signature.all(module.begin(), module.end(), std::back_inserter(indexed_hits), index);
+		EXPECT_EQ(linear_hits, indexed_hits) << pattern;
+
+		// Searching from the middle of a block
+		auto from = module.begin() + 3 * ModuleIndex::BLOCK_SIZE - 1;
+		EXPECT_EQ(signature.next(from, module.end()), signature.next(from, module.end(), index)) << pattern;
+	}
+}
+
+static std::vector<std::vector<std::byte>> split_into_segments(std::span<const std::byte> bytes, std::initializer_list<std::size_t> sizes)
+{
+	std::vector<std::vector<std::byte>> segments;
+	for (std::size_t size : sizes) {
+		segments.emplace_back(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(size));
+		bytes = bytes.subspan(size);
+	}
+	segments.emplace_back(bytes.begin(), bytes.end());
+	return segments;
+}
+
+TEST(SegmentedView, BytePattern)
+{
+	const std::span<const std::byte> flat = std::as_bytes(bytes_span);
+	// Includes empty segments and segments shorter than the pattern
+	const auto segments = split_into_segments(flat, { 10, 0, 2, 1, 27, 11, 0, 40 });
+	const SegmentedView view{ segments };
+
+	for (const auto* pattern : { "e4", "a9 49", "0b ac d2 49 98 2d", "eb e7 64 1e", "14 c0 af", "68 74", "ff ff" }) {
+		const PatternSignature signature = PatternSignature::for_array_of_bytes(pattern);
+
+		std::vector<std::size_t> expected;
+		std::vector<std::size_t> actual;
+		std::vector<std::span<const std::byte>::iterator> flat_hits;
+		signature.all(flat.begin(), flat.end(), std::back_inserter(flat_hits));
+		for (auto hit : flat_hits)
+			expected.push_back(std::distance(flat.begin(), hit));
+
+		std::vector<decltype(view.begin())> segmented_hits;
+		signature.all(view.begin(), view.end(), std::back_inserter(segmented_hits));
+		for (auto hit : segmented_hits)
+			actual.push_back(std::distance(view.begin(), hit));
+
+		EXPECT_EQ(expected, actual) << pattern;
+	}
+}
+
+TEST(SegmentedView, Subrange)
+{
+	const auto segments = split_into_segments(std::as_bytes(bytes_span), { 50, 40 });
+	const SegmentedView view{ segments };
+
+	const PatternSignature signature = PatternSignature::for_array_of_bytes<"a9">();
+	// The last hit at 97 is outside of the range
+	auto end = std::next(view.begin(), 95);
+	std::vector<decltype(view.begin())> hits;
+	signature.all(view.begin(), end, std::back_inserter(hits));
+
+	EXPECT_EQ(hits.size(), 2);
+	EXPECT_EQ(std::distance(view.begin(), hits[0]), 51);
+	EXPECT_EQ(std::distance(view.begin(), hits[1]), 91);
+}
+
+TEST(SegmentedView, XRef)
+{
+	init_xref_array();
+
+	const auto segments = split_into_segments(std::as_bytes(absolute_ref), { 10, 1 });
+	const SegmentedView view{ segments };
+
+	auto signature = XRefSignature{ XRefTypes::absolute(), target };
+	auto hit = signature.next(view.begin(), view.end());
+
+	EXPECT_NE(hit, view.end());
+	EXPECT_EQ(std::distance(view.begin(), hit), 8);
+}
+
+TEST(SegmentedView, XRefEmpty)
+{
+	auto signature = XRefSignature{ XRefTypes::relative_and_absolute(), target };
+
+	const std::vector<std::vector<std::byte>> no_segments;
+	const SegmentedView empty_view{ no_segments };
+	EXPECT_EQ(signature.next(empty_view.begin(), empty_view.end()), empty_view.end());
+
+	const std::vector<std::vector<std::byte>> empty_segments(3);
+	const SegmentedView view{ empty_segments };
+	EXPECT_EQ(signature.next(view.begin(), view.end()), view.end());
+
+	std::vector<decltype(view.begin())> hits;
+	signature.all(view.begin(), view.end(), std::back_inserter(hits));
+	EXPECT_TRUE(hits.empty());
+}
+
+TEST(SegmentedView, XRefNonAdjacentSegments)
+{
+	// Every segment is its own allocation, so there are gaps between them
+	std::vector<std::vector<std::byte>> segments(3, std::vector<std::byte>(32, std::byte{ 0x90 }));
+	const auto target_address = reinterpret_cast<std::uintptr_t>(segments[0].data() + 8);
+	const auto write_call = [target_address](std::vector<std::byte>& segment, std::size_t offset) {
+		segment[offset] = std::byte{ 0xE8 };
+		auto displacement = static_cast<std::int32_t>(target_address - reinterpret_cast<std::uintptr_t>(segment.data() + offset + 5));
+		std::memcpy(segment.data() + offset + 1, &displacement, sizeof(std::int32_t));
+	};
+	write_call(segments[1], 4);
+	write_call(segments[2], 20);
+	const SegmentedView view{ segments };
+
+	const auto offsets_of = [&view](XRefSignature signature) {
+		std::vector<decltype(view.begin())> hits;
+		signature.all(view.begin(), view.end(), std::back_inserter(hits));
+		std::vector<std::ptrdiff_t> offsets;
+		for (auto hit : hits)
+			offsets.push_back(std::distance(view.begin(), hit));
+		return offsets;
+	};
+
+	// Relative matches are at the displacement, instruction-relative ones at the opcode
+	EXPECT_EQ(offsets_of(XRefSignature{ XRefTypes::relative(), target_address }), (std::vector<std::ptrdiff_t>{ 32 + 5, 64 + 21 }));
+	EXPECT_EQ(offsets_of(XRefSignature{ XRefTypes::instruction_relative(), target_address }), (std::vector<std::ptrdiff_t>{ 32 + 4, 64 + 20 }));
+
+	// An explicit location for the first byte applies the same way
+	auto signature = XRefSignature{ XRefTypes::instruction_relative(), target_address };
+	auto hit = signature.next(view.begin(), view.end(), reinterpret_cast<std::uintptr_t>(segments[0].data()));
+	EXPECT_EQ(std::distance(view.begin(), hit), 32 + 4);
+}
+
+TEST(BytePattern, ConstantEvaluation)
+{
+	static constexpr auto OFFSET = [] {
+		constexpr std::array<std::byte, 5> haystack{ std::byte{ 0x13 }, std::byte{ 0x37 }, std::byte{ 0x13 }, std::byte{ 0x38 }, std::byte{ 0x13 } };
+		const PatternSignature signature{ std::array<PatternElement, 2>{ std::byte{ 0x13 }, std::byte{ 0x38 } } };
+		return std::distance(haystack.begin(), signature.next(haystack.begin(), haystack.end()));
+	}();
+	static_assert(OFFSET == 2);
+}
+
+TEST(BytePattern, ContiguousSameAsGeneric)
+{
+	// Small alphabet which includes padding bytes, so that the anchor selection matters
+	constexpr std::array<std::byte, 4> ALPHABET{ std::byte{ 0x00 }, std::byte{ 0xCC }, std::byte{ 0x48 }, std::byte{ 0x8B } };
+	std::vector<std::byte> haystack = random_bytes(2048, 0xC0FFEE, ALPHABET.size());
+	for (std::byte& byte : haystack)
+		byte = ALPHABET[std::to_integer<std::size_t>(byte)];
+	const std::list<std::byte> list{ haystack.begin(), haystack.end() };
+
+	std::uint32_t state = 0xC0FFEE;
+	for (int i = 0; i < 200; i++) {
+		std::vector<PatternElement> elements(1 + random_below(state, 8));
+		for (PatternElement& element : elements)
+			if (random_below(state, 4) != 0)
+				element = ALPHABET[random_below(state, ALPHABET.size())];
+		const PatternSignature signature{ std::move(elements) };
+
+		std::vector<std::size_t> contiguous;
+		std::vector<std::size_t> generic;
+		std::vector<std::vector<std::byte>::iterator> contiguous_hits;
+		std::vector<std::list<std::byte>::const_iterator> generic_hits;
+		signature.all(haystack.begin(), haystack.end(), std::back_inserter(contiguous_hits));
+		signature.all(list.begin(), list.end(), std::back_inserter(generic_hits));
+		for (auto hit : contiguous_hits)
+			contiguous.push_back(std::distance(haystack.begin(), hit));
+		for (auto hit : generic_hits)
+			generic.push_back(std::distance(list.begin(), hit));
+
+		EXPECT_EQ(contiguous, generic) << signature.to_string();
+	}
+}
+
+TEST(ScanBatch, SameAsSerial)
+{
+	init_xref_array();
+
+	const std::vector<std::byte> big = random_bytes(100'000, 0xBADC0DE);
+
+	const std::vector<std::span<const std::byte>> regions{ big, std::as_bytes(bytes_span), std::as_bytes(absolute_ref), std::as_bytes(relative_ref), {} };
+	const std::vector<PatternSignature> patterns{
+		PatternSignature::for_array_of_bytes<"a9">(),
+		PatternSignature::for_array_of_bytes<"0b ac d2 49 98 2d">(),
+		PatternSignature::for_array_of_bytes<"ff ff ff ? ff">(),
+		PatternSignature{ std::vector<PatternElement>(big.begin() + 4094, big.begin() + 4100) },
+		PatternSignature{ std::vector<PatternElement>(big.begin() + 99'990, big.end()) },
+	};
+	const XRefSignature xref{ XRefTypes::relative_and_absolute(), target };
+
+	// Small chunks, so that matches across chunk boundaries are tested as well
+	ScanBatch batch{ 4, 1024 };
+	std::vector<std::future<const std::byte*>> pattern_futures;
+	std::vector<std::future<const std::byte*>> xref_futures;
+	for (const auto& region : regions) {
+		for (const auto& pattern : patterns)
+			pattern_futures.emplace_back(batch.add(pattern, region));
+		xref_futures.emplace_back(batch.add(xref, region));
+	}
+
+	auto pattern_future = pattern_futures.begin();
+	auto xref_future = xref_futures.begin();
+	for (const auto& region : regions) {
+		for (const auto& pattern : patterns)
+			EXPECT_EQ((pattern_future++)->get(), pattern.next(region.data(), region.data() + region.size()));
+		EXPECT_EQ((xref_future++)->get(), xref.next(region.data(), region.data() + region.size()));
+	}
+}
+
+#ifdef __linux__
+static std::byte remote_memory[10'000];
+
+static void fill_remote_memory()
+{
+	std::ranges::copy(random_bytes(sizeof(remote_memory), 0xC0FFEE, 8), remote_memory);
+	// Place some relative references on and near the chunk boundaries
+	for (const std::size_t offset : { std::size_t{ 17 }, std::size_t{ 998 }, std::size_t{ 2999 }, std::size_t{ 5000 }, std::size_t{ 9996 } }) {
+		const auto location = reinterpret_cast<std::uintptr_t>(remote_memory + offset);
+		const auto relative = static_cast<std::int32_t>(reinterpret_cast<std::uintptr_t>(&target) - (location + sizeof(std::int32_t)));
+		std::memcpy(remote_memory + offset, &relative, sizeof(relative));
+	}
+}
+
+TEST(RemoteRegion, SameAsLocal)
+{
+	std::ranges::fill(remote_memory, std::byte{ 0 });
+
+	int ready[2];
+	int finished[2];
+	ASSERT_EQ(pipe(ready), 0);
+	ASSERT_EQ(pipe(finished), 0);
+
+	const pid_t child = fork();
+	ASSERT_NE(child, -1);
+	if (child == 0) {
+		close(ready[0]);
+		close(finished[1]);
+		// Only the memory of the child contains the data, the parent reads it from there
+		fill_remote_memory();
+		char signal = 0;
+		(void)write(ready[1], &signal, 1);
+		(void)read(finished[0], &signal, 1);
+		_exit(0);
+	}
+
+	close(ready[1]);
+	close(finished[0]);
+	char signal = 0;
+	ASSERT_EQ(read(ready[0], &signal, 1), 1);
+	close(ready[0]);
+
+	const std::vector<PatternSignature> patterns{
+		PatternSignature::for_array_of_bytes<"01 02 ? 03">(),
+		PatternSignature::for_array_of_bytes<"07 07 07 07 07">(),
+		PatternSignature::for_array_of_bytes<"00">(),
+	};
+	XRefSignature xref{ XRefTypes::relative(), reinterpret_cast<std::uintptr_t>(&target) };
+
+	// Small chunks, so that more chunks than buffers are needed and matches cross chunk boundaries
+	const RemoteRegion region{ child, reinterpret_cast<std::uintptr_t>(remote_memory), sizeof(remote_memory), 1000 };
+
+	std::vector<std::vector<std::uintptr_t>> remote_hits;
+	std::optional<std::uintptr_t> remote_first;
+	try {
+		for (const PatternSignature& pattern : patterns)
+			region.all(pattern, std::back_inserter(remote_hits.emplace_back()));
+		region.all(xref, std::back_inserter(remote_hits.emplace_back()));
+		remote_first = region.next(patterns.front());
+	} catch (const std::system_error& error) {
+		close(finished[1]);
+		waitpid(child, nullptr, 0);
+		if (error.code() == std::errc::operation_not_permitted)
+			GTEST_SKIP() << "Reading the memory of other processes is not permitted";
+		throw;
+	}
+
+	close(finished[1]);
+	waitpid(child, nullptr, 0);
+
+	fill_remote_memory();
+	const auto to_addresses = [](const std::vector<std::byte*>& hits) {
+		std::vector<std::uintptr_t> addresses;
+		for (const std::byte* hit : hits)
+			addresses.push_back(reinterpret_cast<std::uintptr_t>(hit));
+		return addresses;
+	};
+
+	auto remote = remote_hits.begin();
+	for (const PatternSignature& pattern : patterns) {
+		std::vector<std::byte*> hits;
+		pattern.all(std::begin(remote_memory), std::end(remote_memory), std::back_inserter(hits));
+		EXPECT_FALSE(hits.empty());
+		EXPECT_EQ(*remote++, to_addresses(hits)) << pattern.to_string();
+	}
+
+	std::vector<std::byte*> xref_hits;
+	xref.all(std::begin(remote_memory), std::end(remote_memory), std::back_inserter(xref_hits));
+	EXPECT_EQ(xref_hits.size(), 5);
+	EXPECT_EQ(*remote, to_addresses(xref_hits));
+
+	EXPECT_EQ(remote_first, reinterpret_cast<std::uintptr_t>(patterns.front().next(std::begin(remote_memory), std::end(remote_memory))));
+}
+
+TEST(RemoteRegion, UnmappedMemory)
+{
+	// The first page is never mapped, the error of the reader thread has to reach the caller
+	const RemoteRegion region{ getpid(), 0, 4096, 1000 };
+	const PatternSignature pattern = PatternSignature::for_array_of_bytes<"01 02 ? 03">();
+	EXPECT_THROW((void)region.next(pattern), std::system_error);
+}
+#endif
+
+TEST(TrackedRegion, SameAsFullScan)
+{
+	std::vector<std::byte> region = random_bytes(10 * 4096, 0xFEEDFACE, 8);
+	std::uint32_t state = 0xF00D;
+
+	const PatternSignature pattern = PatternSignature::for_array_of_bytes<"01 02 ? 03">();
+	// Inside of the region, so that every rel32 can reach it
+	const auto xref_target = reinterpret_cast<std::uintptr_t>(region.data() + 5000);
+	XRefSignature xref{ XRefTypes::relative(), xref_target };
+	const auto full_scan = [&region](auto& signature) {
+		std::vector<std::byte*> hits;
+		signature.all(region.data(), region.data() + region.size(), std::back_inserter(hits));
+		return std::vector<const std::byte*>(hits.begin(), hits.end());
+	};
+	const auto matches = [](const TrackedRegion& tracked_region, std::size_t id) {
+		auto span = tracked_region.get_matches(id);
+		return std::vector<const std::byte*>(span.begin(), span.end());
+	};
+
+	TrackedRegion tracked_region{ region };
+	const std::size_t pattern_id = tracked_region.track(pattern);
+	const std::size_t xref_id = tracked_region.track(xref);
+	EXPECT_FALSE(matches(tracked_region, pattern_id).empty());
+	EXPECT_EQ(matches(tracked_region, pattern_id), full_scan(pattern));
+	EXPECT_EQ(matches(tracked_region, xref_id), full_scan(xref));
+	EXPECT_EQ(tracked_region.refresh(), 0);
+
+	bool found_xref = false;
+	for (int round = 0; round < 20; round++) {
+		// Modify a few bytes, sometimes right at page boundaries
+		for (int i = 0; i < 3; i++) {
+			const std::size_t page = random_below(state, 10);
+			const std::size_t offset = page * 4096 + (random_below(state, 2) == 0 ? 4094 : random_below(state, 4096));
+			if (offset + 4 > region.size())
+				continue;
+			if (random_below(state, 2) == 0) {
+				const std::array<std::byte, 4> bytes{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 7 }, std::byte{ 3 } };
+				std::ranges::copy(bytes, region.begin() + static_cast<std::ptrdiff_t>(offset));
+			} else {
+				const auto location = reinterpret_cast<std::uintptr_t>(region.data() + offset);
+				const auto relative = static_cast<std::int32_t>(xref_target - (location + sizeof(std::int32_t)));
+				std::memcpy(region.data() + offset, &relative, sizeof(relative));
+			}
+		}
+
+		EXPECT_NE(tracked_region.refresh(), 0);
+		EXPECT_EQ(matches(tracked_region, pattern_id), full_scan(pattern));
+		EXPECT_EQ(matches(tracked_region, xref_id), full_scan(xref));
+		found_xref |= !matches(tracked_region, xref_id).empty();
+	}
+	EXPECT_TRUE(found_xref);
+}
+
+TEST(BytePattern, Approximate)
+{
+	const PatternSignature signature = PatternSignature::for_array_of_bytes<"98 2d 08 29 b6 f0 43 e4 07 05 fa">();
+	// Bytes 67 to 77 with two bytes changed
+	auto changed = std::vector<std::uint8_t>(bytes_span.begin(), bytes_span.end());
+	changed[69] = 0x00;
+	changed[76] = 0x00;
+
+	EXPECT_TRUE(signature.approximate(changed.begin(), changed.end(), 1).empty());
+	const auto matches = signature.approximate(changed.begin(), changed.end(), 2);
+	ASSERT_EQ(matches.size(), 1);
+	EXPECT_EQ(std::distance(changed.begin(), matches[0].match), 67);
+	EXPECT_EQ(matches[0].distance, 2);
+
+	// Wildcards never count as a mismatch
+	const PatternSignature wildcards = PatternSignature::for_array_of_bytes<"98 2d ? 29 b6 f0 43 e4 07 ? fa">();
+	const auto wildcard_matches = wildcards.approximate(changed.begin(), changed.end(), 0);
+	ASSERT_EQ(wildcard_matches.size(), 1);
+	EXPECT_EQ(std::distance(changed.begin(), wildcard_matches[0].match), 67);
+}
+
+TEST(BytePattern, ApproximateSameAsGeneric)
+{
+	const std::vector<std::byte> haystack = random_bytes(2000, 0x5EED, 4);
+	const std::list<std::byte> list(haystack.begin(), haystack.end());
+
+	std::uint32_t state = 0x5EED;
+	for (int i = 0; i < 50; i++) {
+		std::vector<PatternElement> elements(1 + random_below(state, 20));
+		for (PatternElement& element : elements)
+			if (random_below(state, 4) != 0)
+				element = static_cast<std::byte>(random_below(state, 4));
+		const PatternSignature signature{ std::move(elements) };
+		const std::size_t max_mismatches = random_below(state, 4);
+
+		const auto contiguous = signature.approximate(haystack.begin(), haystack.end(), max_mismatches);
+		const auto generic = signature.approximate(list.begin(), list.end(), max_mismatches);
+		ASSERT_EQ(contiguous.size(), generic.size()) << signature.to_string();
+		for (std::size_t j = 0; j < contiguous.size(); j++) {
+			EXPECT_EQ(std::distance(haystack.begin(), contiguous[j].match), std::distance(list.begin(), generic[j].match));
+			EXPECT_EQ(contiguous[j].distance, generic[j].distance);
+		}
+		EXPECT_TRUE(std::ranges::is_sorted(contiguous, {}, [](const auto& match) { return match.distance; }));
+	}
+
+	// Patterns without concrete bytes match wherever they fit
+	for (const std::size_t length : { 0, 3 }) {
+		const PatternSignature signature{ std::vector<PatternElement>(length) };
+		const auto contiguous = signature.approximate(haystack.begin(), haystack.end(), 0);
+		const auto generic = signature.approximate(list.begin(), list.end(), 0);
+		const std::size_t expected = haystack.size() - std::max<std::size_t>(length, 1) + 1;
+		EXPECT_EQ(contiguous.size(), expected);
+		EXPECT_EQ(generic.size(), expected);
+		EXPECT_TRUE(std::ranges::all_of(contiguous, [](const auto& match) { return match.distance == 0; }));
+	}
+}
+
+TEST(ExtendedPattern, GapsAndAlternatives)
+{
+	// sub rsp, imm8 and sub rsp, imm32 followed by a push
+	const ExtendedPatternSignature signature{ "48 81|83 EC ? [0-3] 53" };
+	EXPECT_FALSE(signature.is_fixed());
+	EXPECT_TRUE(ExtendedPatternSignature{ "48 83 EC ? 53" }.is_fixed());
+
+	const std::array<std::uint8_t, 20> code{
+		0x90, 0x48, 0x83, 0xEC, 0x28, 0x53, 0x90, 0x48, 0x81, 0xEC,
+		0x00, 0x01, 0x00, 0x00, 0x53, 0x48, 0x82, 0xEC, 0x28, 0x53
+	};
+	std::vector<decltype(code)::const_iterator> hits;
+	signature.all(code.begin(), code.end(), std::back_inserter(hits));
+
+	ASSERT_EQ(hits.size(), 2);
+	EXPECT_EQ(std::distance(code.begin(), hits[0]), 1);
+	EXPECT_EQ(std::distance(code.begin(), hits[1]), 7);
+	EXPECT_EQ(std::distance(code.rbegin(), signature.prev(code.rbegin(), code.rend())), 12);
+	EXPECT_TRUE(signature.does_match(code.begin() + 7, code.end()));
+	EXPECT_FALSE(signature.does_match(code.begin() + 15, code.end()));
+}
+
+TEST(ExtendedPattern, SameAsExpansions)
+{
+	std::vector<std::byte> haystack = random_bytes(3000, 0xABCDEF, 3);
+	const std::list<std::byte> list(haystack.begin(), haystack.end());
+
+	std::uint32_t state = 0xABCDEF;
+	for (int i = 0; i < 100; i++) {
+		// "a|b c [min-max] d ?", which is the same as all of "a c <gap> d ?" and "b c <gap> d ?"
+		const std::array<std::string, 4> bytes{ "00", "01", "02", "?" };
+		const std::string a = bytes[random_below(state, 3)];
+		const std::string b = bytes[random_below(state, 4)];
+		const std::string c = bytes[random_below(state, 4)];
+		const std::string d = bytes[random_below(state, 3)];
+		const std::size_t min = random_below(state, 3);
+		const std::size_t max = min + random_below(state, 4);
+		const ExtendedPatternSignature signature{ a + "|" + b + " " + c + " [" + std::to_string(min) + "-" + std::to_string(max) + "] " + d + " ?" };
+
+		// Matches as pairs of first and last byte
+		std::vector<std::pair<std::size_t, std::size_t>> expected;
+		for (const std::string& first : { a, b })
+			for (std::size_t gap = min; gap <= max; gap++) {
+				std::string pattern = first + " " + c;
+				for (std::size_t j = 0; j < gap; j++)
+					pattern += " ?";
+				pattern += " " + d + " ?";
+
+				std::vector<std::vector<std::byte>::iterator> hits;
+				PatternSignature::for_array_of_bytes(pattern).all(haystack.begin(), haystack.end(), std::back_inserter(hits));
+				for (auto hit : hits) {
+					const auto offset = static_cast<std::size_t>(std::distance(haystack.begin(), hit));
+					expected.emplace_back(offset, offset + gap + 3);
+				}
+			}
+		std::ranges::sort(expected);
+
+		std::vector<std::size_t> expected_starts;
+		for (const auto& [first, last] : expected)
+			expected_starts.push_back(first);
+		expected_starts.erase(std::unique(expected_starts.begin(), expected_starts.end()), expected_starts.end());
+
+		std::vector<std::vector<std::byte>::iterator> hits;
+		std::vector<std::list<std::byte>::const_iterator> list_hits;
+		signature.all(haystack.begin(), haystack.end(), std::back_inserter(hits));
+		signature.all(list.begin(), list.end(), std::back_inserter(list_hits));
+		std::vector<std::size_t> starts;
+		std::vector<std::size_t> list_starts;
+		for (auto hit : hits)
+			starts.push_back(std::distance(haystack.begin(), hit));
+		for (auto hit : list_hits)
+			list_starts.push_back(std::distance(list.begin(), hit));
+		EXPECT_EQ(starts, expected_starts);
+		EXPECT_EQ(list_starts, expected_starts);
+
+		// prev finds the match that ends last, and of these the shortest one
+		const auto reverse_hit = signature.prev(haystack.rbegin(), haystack.rend());
+		if (expected.empty()) {
+			EXPECT_EQ(reverse_hit, haystack.rend());
+			continue;
+		}
+		const auto last = std::ranges::max(expected, {}, [](const auto& match) { return std::pair{ match.second, match.first }; });
+		EXPECT_EQ(haystack.size() - 1 - std::distance(haystack.rbegin(), reverse_hit), last.first);
+	}
+}
+
+TEST(TiledScan, SameAsSerial)
+{
+	std::vector<std::byte> region = random_bytes(50'000, 0x7117ED, 64);
+	// Inside of the region, so that the rel32 can reach it
+	const auto xref_target = reinterpret_cast<std::uintptr_t>(region.data() + 40'000);
+	const auto location = reinterpret_cast<std::uintptr_t>(region.data() + 30'000);
+	const auto relative = static_cast<std::int32_t>(xref_target - (location + sizeof(std::int32_t)));
+	std::memcpy(region.data() + 30'000, &relative, sizeof(relative));
+
+	const std::vector<PatternSignature> patterns{
+		PatternSignature::for_array_of_bytes<"01 02 03">(),
+		PatternSignature::for_array_of_bytes<"3f 3f ? 3f 3f">(),
+		PatternSignature{ std::vector<PatternElement>(region.begin() + 1022, region.begin() + 1030) },
+		PatternSignature{ std::vector<PatternElement>(region.begin() + 49'990, region.end()) },
+		PatternSignature::for_array_of_bytes<"ff">(),
+	};
+	const XRefSignature xref{ XRefTypes::relative(), xref_target };
+
+	// Small blocks, so that matches across block boundaries are tested as well
+	TiledScan scan{ 1024 };
+	for (const PatternSignature& pattern : patterns)
+		scan.add(pattern);
+	scan.add(xref);
+
+	const std::vector<const std::byte*> matches = scan.scan(region);
+	ASSERT_EQ(matches.size(), patterns.size() + 1);
+	for (std::size_t i = 0; i < patterns.size(); i++)
+		EXPECT_EQ(matches[i], patterns[i].next(std::as_const(region).data(), region.data() + region.size())) << patterns[i].to_string();
+	EXPECT_EQ(matches.back(), region.data() + 30'000);
+	EXPECT_EQ(matches[4], region.data() + region.size());
+}
+
+TEST(BytePattern, ShortPatterns)
+{
+	// Patterns of every length that is compared as words, at the end of the range where the words can't be loaded as well
+	std::vector<std::byte> haystack(std::as_bytes(bytes_span).begin(), std::as_bytes(bytes_span).end());
+	const std::list<std::byte> list(haystack.begin(), haystack.end());
+	for (std::size_t length = 1; length <= detail::SHORT_PATTERN_LENGTH + 1; length++)
+		for (std::size_t offset : { std::size_t{ 10 }, haystack.size() - length }) {
+			std::vector<PatternElement> elements(haystack.begin() + static_cast<std::ptrdiff_t>(offset), haystack.begin() + static_cast<std::ptrdiff_t>(offset + length));
+			if (length > 2)
+				elements[1] = std::nullopt;
+			const PatternSignature signature{ std::move(elements) };
+
+			std::vector<std::vector<std::byte>::iterator> hits;
+			std::vector<std::list<std::byte>::const_iterator> list_hits;
+			signature.all(haystack.begin(), haystack.end(), std::back_inserter(hits));
+			signature.all(list.begin(), list.end(), std::back_inserter(list_hits));
+			ASSERT_EQ(hits.size(), list_hits.size()) << signature.to_string();
+			for (std::size_t i = 0; i < hits.size(); i++)
+				EXPECT_EQ(std::distance(haystack.begin(), hits[i]), std::distance(list.begin(), list_hits[i])) << signature.to_string();
+			EXPECT_TRUE(std::ranges::any_of(hits, [&](auto hit) { return std::distance(haystack.begin(), hit) == static_cast<std::ptrdiff_t>(offset); }));
+		}
+
+	static_assert([] {
+		constexpr std::array<PatternElement, 10> ELEMENTS{ std::byte{ 1 }, std::nullopt, std::byte{ 3 }, std::byte{ 4 }, std::byte{ 5 }, std::byte{ 6 }, std::byte{ 7 }, std::byte{ 8 }, std::byte{ 9 }, std::byte{ 10 } };
+		std::array<std::byte, 16> bytes{};
+		for (std::size_t i = 0; i < bytes.size(); i++)
+			bytes[i] = static_cast<std::byte>(i + 1);
+		const detail::ShortPattern pattern = detail::pack_short_pattern(ELEMENTS);
+		bool matches = detail::short_pattern_matches(bytes.data(), pattern);
+		bytes[9] = std::byte{ 0 };
+		return matches && !detail::short_pattern_matches(bytes.data(), pattern);
+	}());
+}
+
+TEST(PatternPair, SameAsJoin)
+{
+	std::vector<std::byte> haystack = random_bytes(200'000, 0xDA1A, 8);
+
+	using Iter = std::vector<std::byte>::iterator;
+	const std::array<std::pair<PatternSignature, PatternSignature>, 2> patterns{
+		std::pair{ PatternSignature::for_array_of_bytes<"01 02 ? 03">(), PatternSignature::for_array_of_bytes<"04 05">() },
+		// The second pattern is searched first here
+		std::pair{ PatternSignature::for_array_of_bytes<"06">(), PatternSignature::for_array_of_bytes<"01 ? 02 03">() },
+	};
+	for (const auto& [first, second] : patterns)
+		for (const auto direction : { PatternPair::Direction::FORWARDS, PatternPair::Direction::BACKWARDS })
+			for (const std::size_t max_distance : { std::size_t{ 0 }, std::size_t{ 20 } }) {
+				std::vector<Iter> first_hits;
+				std::vector<Iter> second_hits;
+				first.all(haystack.begin(), haystack.end(), std::back_inserter(first_hits));
+				second.all(haystack.begin(), haystack.end(), std::back_inserter(second_hits));
+
+				std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>> expected;
+				for (const Iter first_hit : first_hits)
+					for (const Iter second_hit : second_hits) {
+						const std::ptrdiff_t distance = direction == PatternPair::Direction::FORWARDS
+							? second_hit - (first_hit + static_cast<std::ptrdiff_t>(first.get_match_length()))
+							: first_hit - (second_hit + static_cast<std::ptrdiff_t>(second.get_match_length()));
+						if (distance >= 0 && distance <= static_cast<std::ptrdiff_t>(max_distance))
+							expected.emplace_back(first_hit - haystack.begin(), second_hit - haystack.begin());
+					}
+
+				const PatternPair pair{ first, second, max_distance, direction };
+				std::vector<PatternPairMatch<Iter>> hits;
+				pair.all(haystack.begin(), haystack.end(), std::back_inserter(hits));
+				std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>> found;
+				for (const auto& hit : hits)
+					found.emplace_back(hit.first - haystack.begin(), hit.second - haystack.begin());
+				std::ranges::sort(found);
+
+				EXPECT_FALSE(expected.empty());
+				EXPECT_EQ(found, expected) << first.to_string() << " / " << second.to_string();
+				const PatternPairMatch<Iter> match = pair.next(haystack.begin(), haystack.end());
+				ASSERT_NE(match.first, haystack.end());
+				EXPECT_EQ(match.first, hits.front().first);
+				EXPECT_EQ(match.second, hits.front().second);
+			}
+}
@@ -0,0 +1,283 @@
+#ifndef SIGNATURESCANNER_EXTENDEDPATTERNSIGNATURE_HPP
+#define SIGNATURESCANNER_EXTENDEDPATTERNSIGNATURE_HPP
+
+#include "PatternSignature.hpp"
+#include "detail/PatternBuilder.hpp"
+#include "detail/PatternParser.hpp"
+#include "detail/SignatureConcept.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner {
+	/**
+	 * A byte pattern which additionally supports gaps of variable length (e.g. "[2-6]" or "[4]")
+	 * and alternatives for a byte (e.g. "E8|E9").
+	 * These are compiled into a bit-parallel automaton (Shift-And), so that all variants are searched in a single pass.
+	 * Patterns which use neither are searched like a PatternSignature.
+	 */
+	class ExtendedPatternSignature {
+		struct Position {
+			std::vector<std::uint8_t> bytes; // Empty if every byte is accepted
+			bool optional = false;
+		};
+
+		/**
+		 * Bit i of a state is set, if the first i + 1 positions match the bytes that were read last.
+		 * Optional positions form blocks, entering the position in front of a block also enters every position of the block.
+		 */
+		struct Automaton {
+			std::array<std::uint64_t, 256> masks{}; // Positions which accept a byte
+			std::uint64_t block_begins = 0; // The position in front of each block
+			std::uint64_t block_ends = 0; // The last position of each block
+			std::uint64_t optional = 0;
+			std::uint64_t final = 0;
+			std::size_t max_length = 0;
+
+			constexpr explicit Automaton(const std::vector<Position>& positions)
+				: max_length(positions.size())
+			{
+				for (std::size_t i = 0; i < positions.size(); i++) {
+					const std::uint64_t bit = std::uint64_t{ 1 } << i;
+					if (positions[i].bytes.empty())
+						for (std::uint64_t& mask : masks)
+							mask |= bit;
+					for (const std::uint8_t byte : positions[i].bytes)
+						masks[byte] |= bit;
+
+					if (!positions[i].optional)
+						continue;
+					optional |= bit;
+					if (!positions[i - 1].optional)
+						block_begins |= bit >> 1;
+					if (!positions[i + 1].optional)
+						block_ends |= bit;
+				}
+				if (!positions.empty())
+					final = std::uint64_t{ 1 } << (positions.size() - 1);
+			}
+
+			[[nodiscard]] constexpr std::uint64_t step(std::uint64_t state, std::uint8_t byte, bool start) const
+			{
+				state = ((state << 1) | (start ? 1 : 0)) & masks[byte];
+				// Subtracting the beginning of a block borrows up to the lowest active position of the block,
+				// every position above that is entered as well.
+				const std::uint64_t with_ends = state | block_ends;
+				return state | (optional & (~(with_ends - block_begins) ^ with_ends));
+			}
+
+			/**
+			 * @returns The last byte of the shortest match starting at it
+			 */
+			template <std::forward_iterator Iter>
+			[[nodiscard]] constexpr std::optional<Iter> anchored_match(Iter it, const std::sentinel_for<Iter> auto& end) const
+			{
+				std::uint64_t state = step(0, to_byte(*it), true);
+				for (std::size_t length = 1; (state & final) == 0; length++) {
+					if (state == 0 || length == max_length)
+						return std::nullopt;
+					if (++it == end)
+						return std::nullopt;
+					state = step(state, to_byte(*it), false);
+				}
+				return it;
+			}
+
+			/**
+			 * @returns The first byte of the earliest starting match
+			 */
+			template <std::forward_iterator Iter, std::sentinel_for<Iter> Sent>
+			[[nodiscard]] constexpr Iter search(const Iter& begin, const Sent& end) const
+			{
+				std::uint64_t state = 0;
+				// Trails it by max_length - 1 bytes, no match ending at it can start before window
+				Iter window = begin;
+				Iter it = begin;
+				for (std::size_t index = 0; it != end; ++it, index++) {
+					if (index >= max_length)
+						++window;
+
+					state = step(state, to_byte(*it), true);
+					if ((state & final) == 0)
+						continue;
+
+					// A match which starts earlier, but ends later, starts in the window as well
+					for (Iter candidate = window;; ++candidate)
+						if (anchored_match(candidate, end).has_value())
+							return candidate;
+				}
+				return it;
+			}
+		};
+
+		// Used if the pattern has neither gaps nor alternatives
+		std::optional<PatternSignature> fixed;
+		std::vector<Position> positions;
+		Automaton forwards;
+		Automaton backwards;
+
+		template <typename T>
+		static constexpr std::uint8_t to_byte(const T& value)
+		{
+			if constexpr (std::same_as<T, std::byte>)
+				return std::to_integer<std::uint8_t>(value);
+			else
+				return std::bit_cast<std::uint8_t>(value);
+		}
+
+		static constexpr std::vector<Position> reversed(std::vector<Position> positions)
+		{
+			std::ranges::reverse(positions);
+			return positions;
+		}
+
+		static constexpr std::optional<PatternSignature> as_fixed(const std::vector<Position>& positions)
+		{
+			std::vector<PatternElement> elements;
+			for (const Position& position : positions) {
+				if (position.optional || position.bytes.size() > 1)
+					return std::nullopt;
+				elements.push_back(position.bytes.empty() ? PatternElement{ std::nullopt } : PatternElement{ static_cast<std::byte>(position.bytes.front()) });
+			}
+			return PatternSignature{ std::move(elements) };
+		}
+
+		static constexpr std::vector<Position> parse(std::string_view string, char delimiter, char wildcard)
+		{
+			std::vector<Position> positions;
+			const auto add_word = [&](std::string_view word) {
+				if (word.starts_with('[')) {
+					word = word.substr(1, word.find(']') - 1);
+					const std::size_t dash = word.find('-');
+					const auto parse_number = [](std::string_view number) {
+						std::size_t value = 0;
+						for (const char c : number)
+							if ('0' <= c && c <= '9')
+								value = value * 10 + (c - '0');
+						return value;
+					};
+					std::size_t min = parse_number(word.substr(0, dash));
+					std::size_t max = dash == std::string_view::npos ? min : parse_number(word.substr(dash + 1));
+					if (max < min)
+						std::swap(min, max);
+
+					positions.insert(positions.end(), min, Position{});
+					positions.insert(positions.end(), max - min, Position{ {}, true });
+					return;
+				}
+
+				Position position;
+				while (!word.empty()) {
+					const std::size_t bar = word.find('|');
+					const PatternElement element = detail::build_word(word.substr(0, bar), wildcard);
+					if (!element.has_value()) {
+						// A wildcard accepts every byte anyway
+						position.bytes.clear();
+						break;
+					}
+					position.bytes.push_back(std::to_integer<std::uint8_t>(element.value()));
+					word = bar == std::string_view::npos ? std::string_view{} : word.substr(bar + 1);
+				}
+				positions.push_back(std::move(position));
+			};
+
+			std::size_t word_begin = 0;
+			for (std::size_t i = 0; i <= string.size(); i++)
+				if (i == string.size() || string[i] == delimiter) {
+					if (i != word_begin)
+						add_word(string.substr(word_begin, i - word_begin));
+					word_begin = i + 1;
+				}
+
+			// Gaps at the beginning or the end don't change whether there is a match, but they would make the start ambiguous
+			while (!positions.empty() && positions.back().optional)
+				positions.pop_back();
+			while (!positions.empty() && positions.front().optional)
+				positions.erase(positions.begin());
+
+			if (positions.size() > MAX_LENGTH)
+				throw std::length_error{ "Extended patterns can't be longer than 64 bytes" };
+			return positions;
+		}
+
+	public:
+		// Longest possible match, this is limited by the width of the state
+		static constexpr std::size_t MAX_LENGTH = 64;
+
+		/**
+		 * @throws std::length_error if the longest possible match exceeds MAX_LENGTH
+		 */
+		explicit constexpr ExtendedPatternSignature(std::string_view string, char delimiter = DEFAULT_DELIMITER, char wildcard = DEFAULT_WILDCARD)
+			: positions(parse(string, delimiter, wildcard))
+			, forwards(positions)
+			, backwards(reversed(positions))
+		{
+			fixed = as_fixed(positions);
+		}
+
+		[[nodiscard]] constexpr bool is_fixed() const { return fixed.has_value(); }
+
+		// Amount of bytes that the longest possible match covers
+		[[nodiscard]] constexpr std::size_t get_match_length() const { return positions.size(); }
+
+		template <std::forward_iterator Iter, std::sentinel_for<Iter> Sent>
+		[[nodiscard]] constexpr Iter next(const Iter& begin, const Sent& end) const
+		{
+			if (fixed.has_value())
+				return fixed->next(begin, end);
+
+			return forwards.search(begin, end);
+		}
+
+		template <std::forward_iterator Iter, std::sentinel_for<Iter> Sent>
+		[[nodiscard]] constexpr Iter prev(const Iter& begin, const Sent& end) const
+		{
+			if (fixed.has_value())
+				return fixed->prev(begin, end);
+
+			const Iter match = backwards.search(begin, end);
+			if (match == end)
+				return match;
+			// Like PatternSignature::prev, this returns the first byte of the pattern
+			return backwards.anchored_match(match, end).value();
+		}
+
+		template <std::forward_iterator Iter>
+		constexpr void all(Iter begin, const std::sentinel_for<Iter> auto& end, std::output_iterator<Iter> auto inserter) const
+		{
+			while (true) {
+				auto it = this->next(begin, end);
+				if (it == end)
+					break;
+				*inserter++ = it;
+				begin = it;
+				begin++;
+			}
+		}
+
+		template <std::forward_iterator Iter>
+		[[nodiscard]] constexpr bool does_match(const Iter& iter, const std::sentinel_for<Iter> auto& end = std::unreachable_sentinel_t{}) const
+		{
+			if (fixed.has_value())
+				return fixed->does_match(iter, end);
+			if (iter == end)
+				return false;
+
+			return forwards.anchored_match(iter, end).has_value();
+		}
+	};
+
+	static_assert(detail::Signature<ExtendedPatternSignature>);
+}
+
+#endif
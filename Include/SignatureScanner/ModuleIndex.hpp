@@ -0,0 +1,138 @@
+#ifndef SIGNATURESCANNER_MODULEINDEX_HPP
+#define SIGNATURESCANNER_MODULEINDEX_HPP
+
+#include "detail/PatternParser.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner {
+	/**
+	 * Remembers which byte pairs occur in each block of a module, so that repeated searches can skip blocks which can't contain a pattern.
+	 * Building the index is a single pass over the module, it has to stay alive (and unchanged) for as long as the index is used.
+	 */
+	class ModuleIndex {
+	public:
+		static constexpr std::size_t BLOCK_SIZE = 4096;
+		// Pairs are hashed into this many bits per block, a quarter of the block size in memory
+		static constexpr std::size_t BITMAP_BITS = 8192;
+		// Amount of byte pairs of a pattern that are checked against the bitmaps
+		static constexpr std::size_t MAX_ANCHORS = 4;
+
+		struct Anchor {
+			std::size_t offset; // Position of the pair in the pattern
+			std::uint16_t pair;
+		};
+
+	private:
+		static constexpr std::size_t WORDS_PER_BLOCK = BITMAP_BITS / 64;
+
+		std::span<const std::byte> module;
+		std::vector<std::uint64_t> bitmaps;
+		std::vector<std::uint32_t> pair_counts;
+
+		static constexpr std::uint16_t make_pair(std::byte first, std::byte second)
+		{
+			return static_cast<std::uint16_t>(std::to_integer<std::uint16_t>(first) << 8 | std::to_integer<std::uint16_t>(second));
+		}
+
+		static constexpr std::size_t hash(std::uint16_t pair)
+		{
+			return (pair * 0x9E3779B1U) >> (32 - std::countr_zero(BITMAP_BITS));
+		}
+
+		[[nodiscard]] std::size_t block_count() const
+		{
+			return bitmaps.size() / WORDS_PER_BLOCK;
+		}
+
+		[[nodiscard]] bool block_contains(std::size_t block, std::uint16_t pair) const
+		{
+			if (block >= block_count())
+				return false;
+			const std::size_t bit = hash(pair);
+			return (bitmaps[block * WORDS_PER_BLOCK + bit / 64] >> (bit % 64)) & 1;
+		}
+
+		[[nodiscard]] bool block_may_contain_start(std::size_t block, std::span<const Anchor> anchors) const
+		{
+			// A match starting in this block has the pair at offset somewhere in [block start + offset, block end + offset),
+			// which covers at most two blocks. Pairs are stored in the block of their first byte.
+			return std::ranges::all_of(anchors, [&](const Anchor& anchor) {
+				const std::size_t first = (block * BLOCK_SIZE + anchor.offset) / BLOCK_SIZE;
+				const std::size_t last = (block * BLOCK_SIZE + BLOCK_SIZE - 1 + anchor.offset) / BLOCK_SIZE;
+				return block_contains(first, anchor.pair) || (last != first && block_contains(last, anchor.pair));
+			});
+		}
+
+	public:
+		explicit ModuleIndex(std::span<const std::byte> module)
+			: module(module)
+			, bitmaps((module.size() + BLOCK_SIZE - 1) / BLOCK_SIZE * WORDS_PER_BLOCK)
+			, pair_counts(1 << 16)
+		{
+			for (std::size_t i = 0; i + 1 < module.size(); i++) {
+				const std::uint16_t pair = make_pair(module[i], module[i + 1]);
+				const std::size_t bit = hash(pair);
+				bitmaps[i / BLOCK_SIZE * WORDS_PER_BLOCK + bit / 64] |= std::uint64_t{ 1 } << (bit % 64);
+				pair_counts[pair]++;
+			}
+		}
+
+		[[nodiscard]] std::span<const std::byte> get_module() const { return module; }
+
+		[[nodiscard]] bool covers(const std::byte* begin, const std::byte* end) const
+		{
+			return module.data() <= begin && begin <= end && end <= module.data() + module.size();
+		}
+
+		/**
+		 * Selects the pairs of adjacent concrete bytes in the pattern that are the rarest in the module.
+		 * If the pattern has no such pairs, then no blocks can be skipped.
+		 */
+		[[nodiscard]] std::vector<Anchor> select_anchors(std::span<const PatternElement> elements) const
+		{
+			std::vector<Anchor> anchors;
+			for (std::size_t i = 0; i + 1 < elements.size(); i++)
+				if (elements[i].has_value() && elements[i + 1].has_value())
+					anchors.emplace_back(i, make_pair(elements[i].value(), elements[i + 1].value()));
+
+			std::ranges::sort(anchors, {}, [this](const Anchor& anchor) { return pair_counts[anchor.pair]; });
+			if (anchors.size() > MAX_ANCHORS)
+				anchors.resize(MAX_ANCHORS);
+			return anchors;
+		}
+
+		/**
+		 * @returns The next run of positions in [begin, end) at which a match might start, {end, end} if there is none.
+		 */
+		[[nodiscard]] std::pair<const std::byte*, const std::byte*> next_candidates(const std::byte* begin, const std::byte* end, std::span<const Anchor> anchors) const
+		{
+			if (begin == end || anchors.empty())
+				return { begin, end };
+
+			const auto block_of = [this](const std::byte* ptr) { return static_cast<std::size_t>(ptr - module.data()) / BLOCK_SIZE; };
+			const auto block_begin = [this](std::size_t block) { return module.data() + std::min(block * BLOCK_SIZE, module.size()); };
+
+			std::size_t block = block_of(begin);
+			const std::size_t last_block = block_of(end - 1);
+			while (block <= last_block && !block_may_contain_start(block, anchors))
+				block++;
+			if (block > last_block)
+				return { end, end };
+
+			std::size_t run_end = block + 1;
+			while (run_end <= last_block && block_may_contain_start(run_end, anchors))
+				run_end++;
+
+			return { std::max(begin, block_begin(block)), std::min(end, block_begin(run_end)) };
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SIGNATURESCANNER_PATTERNPAIR_HPP
+#define SIGNATURESCANNER_PATTERNPAIR_HPP
+
+#include "PatternSignature.hpp"
+#include "detail/PatternSearch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+namespace SignatureScanner {
+	template <std::bidirectional_iterator Iter>
+	struct PatternPairMatch {
+		Iter first;
+		Iter second;
+	};
+
+	/**
+	 * Two patterns, which have to be close to each other, e.g. a call that is followed by a specific comparison.
+	 * Only the more specific pattern is searched in the whole range, the other one only in the bytes around its matches.
+	 */
+	class PatternPair {
+	public:
+		enum class Direction : std::uint8_t {
+			FORWARDS, // second starts at most max_distance bytes after the end of first
+			BACKWARDS, // second ends at most max_distance bytes before the start of first
+		};
+
+	private:
+		PatternSignature first;
+		PatternSignature second;
+		std::size_t max_distance;
+		Direction direction;
+		bool anchor_is_first;
+
+		static std::size_t specificity(const PatternSignature& signature)
+		{
+			std::size_t specificity = 0;
+			for (const PatternElement& element : signature.get_elements())
+				if (element.has_value())
+					specificity += detail::is_padding_byte(element.value()) ? 1 : 2;
+			return specificity;
+		}
+
+		/**
+		 * Calls on_pair for every pair with a match of the anchor at anchor_match, until it returns false.
+		 * @returns Whether on_pair returned true every time
+		 */
+		template <std::bidirectional_iterator Iter, std::sentinel_for<Iter> Sent>
+		constexpr bool partners(const Iter& begin, const Sent& end, const Iter& anchor_match, const auto& on_pair) const
+		{
+			const PatternSignature& anchor = anchor_is_first ? first : second;
+			const PatternSignature& partner = anchor_is_first ? second : first;
+			// Whether the partner is behind the anchor
+			const bool partner_behind = anchor_is_first == (direction == Direction::FORWARDS);
+
+			using Difference = std::iter_difference_t<Iter>;
+			const auto window_size = static_cast<Difference>(max_distance + partner.get_match_length());
+
+			Iter window_begin;
+			Iter window_end;
+			if (partner_behind) {
+				// The partner starts at most max_distance bytes after the end of the anchor
+				window_begin = std::ranges::next(anchor_match, static_cast<Difference>(anchor.get_match_length()), end);
+				window_end = std::ranges::next(window_begin, window_size, end);
+			} else {
+				// The partner ends at most max_distance bytes before the start of the anchor
+				window_begin = std::ranges::prev(anchor_match, window_size, begin);
+				window_end = anchor_match;
+			}
+
+			for (Iter it = window_begin;; it++) {
+				it = partner.next(it, window_end);
+				if (it == window_end)
+					return true;
+				if (!(anchor_is_first ? on_pair(PatternPairMatch<Iter>{ anchor_match, it }) : on_pair(PatternPairMatch<Iter>{ it, anchor_match })))
+					return false;
+			}
+		}
+
+		template <std::bidirectional_iterator Iter, std::sentinel_for<Iter> Sent>
+		constexpr void pairs(const Iter& begin, const Sent& end, const auto& on_pair) const
+		{
+			const PatternSignature& anchor = anchor_is_first ? first : second;
+			for (Iter it = begin;; it++) {
+				it = anchor.next(it, end);
+				if (it == end || !partners(begin, end, it, on_pair))
+					return;
+			}
+		}
+
+	public:
+		PatternPair(PatternSignature first, PatternSignature second, std::size_t max_distance, Direction direction = Direction::FORWARDS)
+			: first(std::move(first))
+			, second(std::move(second))
+			, max_distance(max_distance)
+			, direction(direction)
+			, anchor_is_first(specificity(this->first) >= specificity(this->second))
+		{
+		}
+
+		/**
+		 * @returns The first pair in the order of all, both iterators are end if there is none
+		 */
+		template <std::bidirectional_iterator Iter, std::sentinel_for<Iter> Sent>
+		[[nodiscard]] constexpr PatternPairMatch<Iter> next(const Iter& begin, const Sent& end) const
+		{
+			const Iter last = std::ranges::next(begin, end);
+			PatternPairMatch<Iter> match{ last, last };
+			pairs(begin, end, [&match](const PatternPairMatch<Iter>& pair) {
+				match = pair;
+				return false;
+			});
+			return match;
+		}
+
+		/**
+		 * Finds every pair, a match can be part of multiple pairs.
+		 * The pairs are ordered by the match of the more specific pattern, since that is the one which is searched.
+		 */
+		template <std::bidirectional_iterator Iter>
+		constexpr void all(const Iter& begin, const std::sentinel_for<Iter> auto& end, std::output_iterator<PatternPairMatch<Iter>> auto inserter) const
+		{
+			pairs(begin, end, [&inserter](const PatternPairMatch<Iter>& pair) {
+				*inserter++ = pair;
+				return true;
+			});
+		}
+	};
+}
+
+#endif
@@ -1,19 +1,33 @@
 #ifndef SIGNATURESCANNER_PATTERNSIGNATURE_HPP
 #define SIGNATURESCANNER_PATTERNSIGNATURE_HPP
 
+#include "ModuleIndex.hpp"
+#include "detail/ApproximateSearch.hpp"
 #include "detail/SignatureConcept.hpp"
 #include "detail/PatternBuilder.hpp"
 #include "detail/PatternParser.hpp"
+#include "detail/PatternSearch.hpp"
+#include "detail/SegmentedSearch.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <span>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 namespace SignatureScanner {
+	template <std::forward_iterator Iter>
+	struct ApproximateMatch {
+		Iter match;
+		// Amount of concrete bytes that differ from the pattern
+		std::size_t distance;
+	};
+
 	class PatternSignature {
 		std::vector<PatternElement> elements;
 
@@ -61,26 +75,103 @@ namespace SignatureScanner {
 
 		[[nodiscard]] constexpr const std::vector<PatternElement>& get_elements() const { return elements; }
 
-#ifdef SIGNATURESCANNER_OPTIMIZE
+		// Amount of bytes that a match covers
+		[[nodiscard]] constexpr std::size_t get_match_length() const { return elements.size(); }
+
+		// IDA-style signature, e.g. "E8 ? ? ? ? 48 8B", which for_array_of_bytes can parse again
+		[[nodiscard]] std::string to_string(char delimiter = DEFAULT_DELIMITER, char wildcard = DEFAULT_WILDCARD) const
+		{
+			constexpr std::string_view HEX_DIGITS = "0123456789ABCDEF";
+
+			std::string string;
+			for (const PatternElement& element : elements) {
+				if (!string.empty())
+					string += delimiter;
+
+				if (!element.has_value()) {
+					string += wildcard;
+					continue;
+				}
+
+				const auto byte = std::to_integer<std::uint8_t>(element.value());
+				string += HEX_DIGITS[byte >> 4];
+				string += HEX_DIGITS[byte & 0xF];
+			}
+			return string;
+		}
+
 	private:
+#ifdef SIGNATURESCANNER_OPTIMIZE
+		// These call the contiguous search functions, but in an optimized translation unit.
 		const std::byte* optimized_next(const std::byte* begin, const std::byte* end) const;
 		const std::byte* optimized_prev(const std::byte* begin, const std::byte* end) const;
+		void optimized_approximate(const std::byte* begin, const std::byte* end, std::size_t max_mismatches, std::vector<detail::ApproximateHit>& hits) const;
+#endif
 
-	public:
+		const std::byte* contiguous_next(const std::byte* begin, const std::byte* end) const
+		{
+#ifdef SIGNATURESCANNER_OPTIMIZE
+			return optimized_next(begin, end);
+#else
+			return detail::find_pattern(begin, end, elements);
 #endif
+		}
+
+		void contiguous_approximate(const std::byte* begin, const std::byte* end, std::size_t max_mismatches, std::vector<detail::ApproximateHit>& hits) const
+		{
+#ifdef SIGNATURESCANNER_OPTIMIZE
+			optimized_approximate(begin, end, max_mismatches, hits);
+#else
+			detail::find_approximate(begin, end, detail::pack_pattern(elements), max_mismatches, hits);
+#endif
+		}
+
+		const std::byte* indexed_next(const std::byte* begin, const std::byte* end, const ModuleIndex& index, std::span<const ModuleIndex::Anchor> anchors) const
+		{
+			const std::byte* it = begin;
+			while (it != end) {
+				auto [candidates_begin, candidates_end] = index.next_candidates(it, end, anchors);
+				if (candidates_begin == end)
+					break;
+
+				// Matches starting in the candidate run may reach into the following bytes
+				const std::byte* search_end = static_cast<std::size_t>(end - candidates_end) < elements.size()
+					? end
+					: candidates_end + elements.size() - 1;
+				const std::byte* match = next(candidates_begin, search_end);
+				if (match < candidates_end)
+					return match;
+
+				it = candidates_end;
+			}
+			return end;
+		}
+
+		template <std::input_iterator Iter, std::sentinel_for<Iter> Sent>
+		constexpr Iter reverse_search(const Iter& begin, const Sent& end) const
+		{
+			return std::ranges::search(begin, end, elements.crbegin(), elements.crend(), detail::pattern_compare<std::iter_value_t<Iter>>).end();
+		}
 
+	public:
 		template <std::input_iterator Iter, std::sentinel_for<Iter> Sent>
 		[[nodiscard]] constexpr Iter next(const Iter& begin, const Sent& end) const
 		{
-#ifdef SIGNATURESCANNER_OPTIMIZE
 			if constexpr (std::contiguous_iterator<Iter> && std::contiguous_iterator<Sent> && sizeof(std::iter_value_t<Iter>) == 1) {
-				const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
-				const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+				if !consteval {
+					const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
+					const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
 
-				auto match_dist = optimized_next(begin_ptr, end_ptr) - begin_ptr;
-				return std::next(begin, match_dist);
+					auto match_dist = contiguous_next(begin_ptr, end_ptr) - begin_ptr;
+					return std::next(begin, match_dist);
+				}
+			}
+			if constexpr (detail::SegmentedIterator<Iter, Sent>) {
+				return detail::segmented_next(
+					begin, end, elements.size(), 0,
+					[this](const auto* segment_begin, const auto* segment_end, std::uintptr_t /*location*/) { return next(segment_begin, segment_end); },
+					[this](const Iter& it, const Sent& sent, std::uintptr_t /*location*/) { return does_match(it, sent); });
 			}
-#endif
 			return std::ranges::search(begin, end, elements.cbegin(), elements.cend(), detail::pattern_compare<std::iter_value_t<Iter>>).begin();
 		}
 
@@ -89,15 +180,20 @@ namespace SignatureScanner {
 		{
 			Iter match;
 #ifdef SIGNATURESCANNER_OPTIMIZE
+			// The optimized version walks downwards from begin, header-only it is searched like any other range
 			if constexpr (std::contiguous_iterator<Iter> && std::contiguous_iterator<Sent> && sizeof(std::iter_value_t<Iter>) == 1) {
-				const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
-				const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+				if !consteval {
+					const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
+					const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
 
-				auto match_dist = optimized_prev(begin_ptr, end_ptr) - begin_ptr;
-				match = std::next(begin, match_dist);
+					auto match_dist = optimized_prev(begin_ptr, end_ptr) - begin_ptr;
+					match = std::next(begin, match_dist);
+				} else {
+					match = reverse_search(begin, end);
+				}
 			} else
 #endif
-				match = std::ranges::search(begin, end, elements.crbegin(), elements.crend(), detail::pattern_compare<std::iter_value_t<Iter>>).end();
+				match = reverse_search(begin, end);
 
 			if (match != end)
 				// This match will be one-after-the-end of the pattern, for consistency we need the first byte (from the beginning).
@@ -119,6 +215,89 @@ namespace SignatureScanner {
 			}
 		}
 
+		// Matches in which at most max_mismatches concrete bytes differ (e.g. after an update), ordered by distance and then by position.
+		// Wildcards never differ, so a pattern without concrete bytes matches wherever it fits.
+		template <std::forward_iterator Iter, std::sentinel_for<Iter> Sent>
+		[[nodiscard]] constexpr std::vector<ApproximateMatch<Iter>> approximate(const Iter& begin, const Sent& end, std::size_t max_mismatches) const
+		{
+			std::vector<ApproximateMatch<Iter>> matches;
+			if constexpr (std::contiguous_iterator<Iter> && std::contiguous_iterator<Sent> && sizeof(std::iter_value_t<Iter>) == 1) {
+				if !consteval {
+					const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
+					const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+
+					std::vector<detail::ApproximateHit> hits;
+					contiguous_approximate(begin_ptr, end_ptr, max_mismatches, hits);
+					for (const auto& [offset, distance] : hits)
+						matches.push_back({ std::next(begin, offset), distance });
+
+					std::ranges::stable_sort(matches, {}, &ApproximateMatch<Iter>::distance);
+					return matches;
+				}
+			}
+
+			for (Iter it = begin; it != end; it++) {
+				std::size_t distance = 0;
+				Iter byte = it;
+				bool fits = true;
+				for (const PatternElement& element : elements) {
+					if (byte == end) {
+						fits = false;
+						break;
+					}
+					if (!detail::pattern_compare(*byte, element) && ++distance > max_mismatches)
+						break;
+					byte++;
+				}
+				if (!fits)
+					break;
+				if (distance <= max_mismatches)
+					matches.push_back({ it, distance });
+			}
+
+			std::ranges::stable_sort(matches, {}, &ApproximateMatch<Iter>::distance);
+			return matches;
+		}
+
+		// Same as next, but skips the blocks of the module that can't contain the pattern, the index is ignored outside of the module
+		template <std::contiguous_iterator Iter>
+			requires(sizeof(std::iter_value_t<Iter>) == 1)
+		[[nodiscard]] Iter next(const Iter& begin, const Iter& end, const ModuleIndex& index) const
+		{
+			const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
+			const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+
+			if (!index.covers(begin_ptr, end_ptr))
+				return next(begin, end);
+
+			auto match_dist = indexed_next(begin_ptr, end_ptr, index, index.select_anchors(elements)) - begin_ptr;
+			return std::next(begin, match_dist);
+		}
+
+		template <std::contiguous_iterator Iter>
+			requires(sizeof(std::iter_value_t<Iter>) == 1)
+		void all(Iter begin, const Iter& end, std::output_iterator<Iter> auto inserter, const ModuleIndex& index) const
+		{
+			const auto* begin_ptr = reinterpret_cast<const std::byte*>(std::to_address(begin));
+			const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+
+			if (!index.covers(begin_ptr, end_ptr)) {
+				all(begin, end, inserter);
+				return;
+			}
+
+			// The anchors only depend on the pattern, so they are selected once for all matches
+			const std::vector<ModuleIndex::Anchor> anchors = index.select_anchors(elements);
+			const std::byte* it = begin_ptr;
+			while (true) {
+				const std::byte* match = indexed_next(it, end_ptr, index, anchors);
+				if (match == end_ptr)
+					break;
+				*inserter++ = std::next(begin, match - begin_ptr);
+				it = match + 1;
+			}
+		}
+
 		template <std::input_iterator Iter>
 		[[nodiscard]] constexpr bool does_match(const Iter& iter, const std::sentinel_for<Iter> auto& end = std::unreachable_sentinel_t{}) const
 		{
@@ -0,0 +1,188 @@
+#ifndef SIGNATURESCANNER_REMOTEREGION_HPP
+#define SIGNATURESCANNER_REMOTEREGION_HPP
+
+#ifdef __linux__
+
+#include "detail/ChunkedSearch.hpp"
+#include "detail/SignatureConcept.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace SignatureScanner {
+	/**
+	 * A region in the memory of another process, which is read in chunks using process_vm_readv.
+	 * While one chunk is searched, a reader thread is already reading the following ones.
+	 * Matches are reported as addresses in the other process, XRefs are searched relative to these as well.
+	 * Failing reads throw a std::system_error.
+	 */
+	class RemoteRegion {
+		pid_t pid;
+		std::uintptr_t address;
+		std::size_t size;
+		std::size_t chunk_size;
+
+		void read(std::uintptr_t remote_address, std::byte* buffer, std::size_t length) const
+		{
+			const iovec local{ buffer, length };
+			const iovec remote{ reinterpret_cast<void*>(remote_address), length };
+			const ssize_t bytes_read = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+			if (bytes_read < 0)
+				throw std::system_error{ errno, std::system_category(), "process_vm_readv" };
+			if (static_cast<std::size_t>(bytes_read) != length)
+				// The region reaches into memory that is not mapped
+				throw std::system_error{ EFAULT, std::system_category(), "process_vm_readv" };
+		}
+
+		template <detail::ContiguousSignature Sig>
+		static const std::byte* search(const Sig& signature, const std::byte* it, const std::byte* end, std::uintptr_t location)
+		{
+			if constexpr (requires { signature.next(it, end, location); })
+				return signature.next(it, end, location);
+			else
+				return signature.next(it, end);
+		}
+
+		/**
+		 * Calls on_match with the remote address of every match until it returns false.
+		 */
+		template <detail::ContiguousSignature Sig>
+		void scan(const Sig& signature, const auto& on_match) const
+		{
+			// The last bytes of a chunk are searched together with the next chunk
+			const std::size_t overlap = detail::chunk_overlap(signature.get_match_length());
+			const std::size_t chunks = (size + chunk_size - 1) / chunk_size;
+
+			std::array<std::vector<std::byte>, BUFFER_COUNT> buffers;
+			for (std::vector<std::byte>& buffer : buffers)
+				buffer.resize(overlap + chunk_size);
+			std::vector<std::byte> carry;
+			carry.reserve(overlap);
+
+			std::mutex mutex;
+			std::condition_variable_any condition;
+			std::size_t chunks_read = 0;
+			// The buffers of these chunks can be reused
+			std::size_t chunks_searched = 0;
+			std::exception_ptr read_error;
+
+			// Declared after the buffers, so that the reader is stopped and joined before the buffers are freed
+			const std::jthread reader{ [&](const std::stop_token& stop) {
+				for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+					{
+						std::unique_lock lock{ mutex };
+						if (!condition.wait(lock, stop, [&] { return chunk < chunks_searched + BUFFER_COUNT; }))
+							return;
+					}
+
+					const std::size_t offset = chunk * chunk_size;
+					try {
+						read(address + offset, buffers[chunk % BUFFER_COUNT].data() + overlap, std::min(chunk_size, size - offset));
+					} catch (...) {
+						const std::lock_guard lock{ mutex };
+						read_error = std::current_exception();
+						condition.notify_all();
+						return;
+					}
+
+					const std::lock_guard lock{ mutex };
+					chunks_read++;
+					condition.notify_all();
+				}
+			} };
+
+			for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+				{
+					std::unique_lock lock{ mutex };
+					condition.wait(lock, [&] { return chunks_read > chunk || read_error; });
+					if (chunks_read <= chunk)
+						std::rethrow_exception(read_error);
+				}
+
+				std::vector<std::byte>& buffer = buffers[chunk % BUFFER_COUNT];
+				std::byte* begin = buffer.data() + overlap - carry.size();
+				const std::byte* end = buffer.data() + overlap + std::min(chunk_size, size - chunk * chunk_size);
+				std::ranges::copy(carry, begin);
+				const std::uintptr_t location = address + chunk * chunk_size - carry.size();
+
+				// Matches have to start in front of limit, the others are searched again once the next chunk is there
+				const bool is_last = chunk + 1 == chunks;
+				const std::byte* limit = is_last ? end : end - std::min<std::size_t>(overlap, end - begin);
+
+				for (const std::byte* it = begin; it < limit;) {
+					const std::byte* match = search(signature, it, end, location + (it - begin));
+					if (match >= limit)
+						break;
+					if (!on_match(location + (match - begin)))
+						return;
+					it = match + 1;
+				}
+
+				carry.assign(limit, end);
+
+				const std::lock_guard lock{ mutex };
+				chunks_searched++;
+				condition.notify_all();
+			}
+		}
+
+	public:
+		static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+		// Up to this many chunks are read ahead
+		static constexpr std::size_t BUFFER_COUNT = 3;
+
+		RemoteRegion(pid_t pid, std::uintptr_t address, std::size_t size, std::size_t chunk_size = DEFAULT_CHUNK_SIZE)
+			: pid(pid)
+			, address(address)
+			, size(size)
+			, chunk_size(std::max<std::size_t>(chunk_size, 1))
+		{
+		}
+
+		[[nodiscard]] pid_t get_pid() const { return pid; }
+		[[nodiscard]] std::uintptr_t get_address() const { return address; }
+		[[nodiscard]] std::size_t get_size() const { return size; }
+
+		/**
+		 * @returns The remote address of the first match
+		 */
+		template <detail::ContiguousSignature Sig>
+		[[nodiscard]] std::optional<std::uintptr_t> next(const Sig& signature) const
+		{
+			std::optional<std::uintptr_t> match;
+			scan(signature, [&match](std::uintptr_t location) {
+				match = location;
+				return false;
+			});
+			return match;
+		}
+
+		template <detail::ContiguousSignature Sig>
+		void all(const Sig& signature, std::output_iterator<std::uintptr_t> auto inserter) const
+		{
+			scan(signature, [&inserter](std::uintptr_t location) {
+				*inserter++ = location;
+				return true;
+			});
+		}
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef SIGNATURESCANNER_SCANBATCH_HPP
+#define SIGNATURESCANNER_SCANBATCH_HPP
+
+#include "detail/ChunkedSearch.hpp"
+#include "detail/SignatureConcept.hpp"
+#include "detail/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+
+namespace SignatureScanner {
+	/**
+	 * Resolves many signatures in the background.
+	 * Every job is split into chunks, so that big regions are spread over all threads while small ones are still one task.
+	 * Destroying the batch waits for all jobs to finish.
+	 */
+	class ScanBatch {
+		std::size_t chunk_size;
+		detail::WorkStealingPool pool;
+
+	public:
+		static constexpr std::size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+		explicit ScanBatch(std::size_t thread_count = std::thread::hardware_concurrency(), std::size_t chunk_size = DEFAULT_CHUNK_SIZE)
+			: chunk_size(std::max<std::size_t>(chunk_size, 1))
+			, pool(thread_count)
+		{
+		}
+
+		[[nodiscard]] std::size_t get_thread_count() const { return pool.get_thread_count(); }
+
+		/**
+		 * Queues a search for the first match of signature in region.
+		 * @returns A future of the match, which is the end of the region if there is none
+		 */
+		template <detail::ContiguousSignature Sig>
+		std::future<const std::byte*> add(Sig signature, std::span<const std::byte> region)
+		{
+			struct Job {
+				Sig signature;
+				std::span<const std::byte> region;
+				std::promise<const std::byte*> promise;
+				std::atomic<std::size_t> remaining_chunks;
+				std::atomic<std::size_t> first_match; // Offset into the region
+			};
+
+			const std::size_t chunks = std::max<std::size_t>((region.size() + chunk_size - 1) / chunk_size, 1);
+			auto job = std::make_shared<Job>(std::move(signature), region, std::promise<const std::byte*>{}, chunks, region.size());
+			auto future = job->promise.get_future();
+
+			for (std::size_t chunk = 0; chunk < chunks; chunk++)
+				pool.submit([job, begin = chunk * chunk_size, end = std::min(region.size(), (chunk + 1) * chunk_size)] {
+					// Chunks behind a match that was already found don't matter anymore
+					if (job->first_match.load() > begin) {
+						const std::size_t overlap = detail::chunk_overlap(job->signature.get_match_length());
+						const std::byte* data = job->region.data();
+						const std::byte* match = job->signature.next(data + begin, data + std::min(job->region.size(), end + overlap));
+
+						const auto offset = static_cast<std::size_t>(match - data);
+						std::size_t first_match = job->first_match.load();
+						while (offset < end && offset < first_match && !job->first_match.compare_exchange_weak(first_match, offset)) {
+							// Another chunk reported a match in the meantime, first_match was updated by the failed exchange
+						}
+					}
+
+					if (--job->remaining_chunks == 0)
+						job->promise.set_value(job->region.data() + job->first_match.load());
+				});
+
+			return future;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SIGNATURESCANNER_SEGMENTEDVIEW_HPP
+#define SIGNATURESCANNER_SEGMENTEDVIEW_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace SignatureScanner {
+	/**
+	 * Presents a range of contiguous segments (e.g. a list of pages or both halves of a ring buffer) as a single range of bytes.
+	 * Signatures recognize the iterators of this view and search every segment with the same code that is used for contiguous ranges,
+	 * matches which span multiple segments are found as well.
+	 * XRefSignature matches bytes at the real addresses of their segments, even if the segments aren't adjacent.
+	 * The view doesn't own the segments.
+	 */
+	template <std::ranges::forward_range Segments>
+		requires std::ranges::contiguous_range<std::ranges::range_reference_t<const Segments>>
+		&& (sizeof(std::ranges::range_value_t<std::ranges::range_reference_t<const Segments>>) == 1)
+	class SegmentedView : public std::ranges::view_interface<SegmentedView<Segments>> {
+		using SegmentIterator = std::ranges::iterator_t<const Segments>;
+		using SegmentSentinel = std::ranges::sentinel_t<const Segments>;
+		using Pointer = decltype(std::ranges::data(*std::declval<SegmentIterator>()));
+
+		const Segments* segments;
+
+	public:
+		class Iterator {
+			SegmentIterator segment{};
+			SegmentSentinel segments_end{};
+			std::size_t offset = 0;
+
+			constexpr void skip_empty_segments()
+			{
+				while (segment != segments_end && std::ranges::empty(*segment))
+					segment++;
+			}
+
+		public:
+			// NOLINTBEGIN(readability-identifier-naming)
+			using value_type = std::remove_cv_t<std::remove_pointer_t<Pointer>>;
+			using difference_type = std::ptrdiff_t;
+			using iterator_concept = std::forward_iterator_tag;
+			// NOLINTEND(readability-identifier-naming)
+
+			constexpr Iterator() = default;
+
+			constexpr Iterator(SegmentIterator segment, SegmentSentinel segments_end, std::size_t offset = 0)
+				: segment(std::move(segment))
+				, segments_end(std::move(segments_end))
+				, offset(offset)
+			{
+				skip_empty_segments();
+			}
+
+			constexpr decltype(auto) operator*() const { return std::ranges::data(*segment)[offset]; }
+			// The end has no byte to point at, but std::to_address may still be used on it
+			constexpr Pointer operator->() const { return segment == segments_end ? nullptr : std::ranges::data(*segment) + offset; }
+
+			constexpr Iterator& operator++()
+			{
+				if (++offset == std::ranges::size(*segment)) {
+					segment++;
+					offset = 0;
+					skip_empty_segments();
+				}
+				return *this;
+			}
+
+			constexpr Iterator operator++(int)
+			{
+				Iterator it = *this;
+				++*this;
+				return it;
+			}
+
+			constexpr bool operator==(const Iterator& other) const
+			{
+				return segment == other.segment && offset == other.offset;
+			}
+
+			constexpr bool operator==(std::default_sentinel_t /*unused*/) const
+			{
+				return segment == segments_end;
+			}
+
+			/**
+			 * @returns The rest of the current segment, but not more than up to end
+			 */
+			[[nodiscard]] constexpr std::span<std::remove_pointer_t<Pointer>> remaining_segment(const Iterator& end) const
+			{
+				auto* begin = std::ranges::data(*segment);
+				if (segment == end.segment)
+					return { begin + offset, begin + end.offset };
+				return { begin + offset, begin + std::ranges::size(*segment) };
+			}
+
+			[[nodiscard]] constexpr std::span<std::remove_pointer_t<Pointer>> remaining_segment(std::default_sentinel_t /*unused*/) const
+			{
+				auto* begin = std::ranges::data(*segment);
+				return { begin + offset, begin + std::ranges::size(*segment) };
+			}
+
+			/**
+			 * @returns An iterator pointing n bytes further, which have to be inside of the current segment
+			 */
+			[[nodiscard]] constexpr Iterator advanced_in_segment(std::size_t n) const
+			{
+				Iterator it = *this;
+				it.offset += n;
+				if (it.offset == std::ranges::size(*segment)) {
+					it.segment++;
+					it.offset = 0;
+					it.skip_empty_segments();
+				}
+				return it;
+			}
+		};
+
+		constexpr explicit SegmentedView(const Segments& segments)
+			: segments(std::addressof(segments))
+		{
+		}
+
+		[[nodiscard]] constexpr Iterator begin() const { return Iterator{ std::ranges::begin(*segments), std::ranges::end(*segments) }; }
+		[[nodiscard]] constexpr std::default_sentinel_t end() const { return std::default_sentinel; }
+	};
+}
+
+#endif
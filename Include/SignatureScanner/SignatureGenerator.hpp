@@ -0,0 +1,172 @@
+#ifndef SIGNATURESCANNER_SIGNATUREGENERATOR_HPP
+#define SIGNATURESCANNER_SIGNATUREGENERATOR_HPP
+
+#include "PatternSignature.hpp"
+#include "detail/PatternParser.hpp"
+#include "detail/SuffixArray.hpp"
+#include "detail/X86Reference.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner {
+	/**
+	 * Generates the shortest signatures that uniquely identify an address in a module.
+	 * The module is indexed with a suffix array once, afterwards generating a signature only needs a few binary searches.
+	 */
+	class SignatureGenerator {
+		std::span<const std::byte> module;
+		std::vector<std::int32_t> suffix_array;
+		std::vector<std::size_t> relocations;
+
+	public:
+		static constexpr std::size_t DEFAULT_MAX_LENGTH = 128;
+
+		/**
+		 * @param relocations Offsets of pointer-sized values in the module, which will be relocated by the loader.
+		 * These are masked in generated signatures, as are the rel32 operands of instructions that reference other code or data.
+		 */
+		explicit SignatureGenerator(std::span<const std::byte> module, std::vector<std::size_t> relocations = {})
+			: module(module)
+			, suffix_array(detail::build_suffix_array(std::span{ reinterpret_cast<const std::uint8_t*>(module.data()), module.size() }, 0xFF))
+			, relocations(std::move(relocations))
+		{
+			std::ranges::sort(this->relocations);
+		}
+
+		[[nodiscard]] std::span<const std::byte> get_module() const { return module; }
+
+		/**
+		 * @returns The shortest signature starting at address which only matches at address,
+		 * std::nullopt if no signature of at most max_length bytes is unique or if the address is not inside the module.
+		 */
+		[[nodiscard]] std::optional<PatternSignature> generate(const std::byte* address, std::size_t max_length = DEFAULT_MAX_LENGTH) const
+		{
+			if (address < module.data() || address >= module.data() + module.size())
+				return std::nullopt;
+
+			const auto offset = static_cast<std::size_t>(address - module.data());
+			max_length = std::min(max_length, module.size() - offset);
+
+			const std::vector<bool> wildcards = find_wildcards(offset, max_length);
+
+			std::vector<PatternElement> elements;
+			elements.reserve(max_length);
+			for (std::size_t i = 0; i < max_length; i++) {
+				if (wildcards[i]) {
+					elements.emplace_back(std::nullopt);
+					continue;
+				}
+				elements.emplace_back(module[offset + i]);
+
+				// Only patterns ending in a concrete byte are candidates, a trailing wildcard can't make a pattern more unique.
+				if (is_unique(elements))
+					return PatternSignature{ std::move(elements) };
+			}
+
+			return std::nullopt;
+		}
+
+	private:
+		[[nodiscard]] std::vector<bool> find_wildcards(std::size_t offset, std::size_t length) const
+		{
+			std::vector<bool> wildcards(length);
+			const auto mask = [&](std::size_t begin, std::size_t size) {
+				for (std::size_t i = begin; i < begin + size; i++)
+					if (i >= offset && i - offset < length)
+						wildcards[i - offset] = true;
+			};
+
+			// A relocation could begin in front of the address and still reach into it
+			const std::size_t first_relocation = offset >= sizeof(void*) ? offset - sizeof(void*) + 1 : 0;
+			for (auto it = std::ranges::lower_bound(relocations, first_relocation); it != relocations.end() && *it < offset + length; it++)
+				mask(*it, sizeof(void*));
+
+			const auto byte_before = [this](std::size_t index, std::size_t n) -> std::optional<std::uint8_t> {
+				if (index < n)
+					return std::nullopt;
+				return std::to_integer<std::uint8_t>(module[index - n]);
+			};
+
+			// Not a disassembler, but if this were to mistake data for an instruction, then that only makes the signature longer.
+			for (std::size_t i = offset; i < offset + length;) {
+				const auto instruction = module.subspan(i);
+				const bool operand_size_prefix = detail::has_operand_size_prefix(byte_before(i, 1), byte_before(i, 2));
+				if (auto reference = detail::decode_x86_reference(instruction.begin(), instruction.end(), operand_size_prefix)) {
+					mask(i + reference->displacement_offset, sizeof(std::int32_t));
+					i += reference->instruction_length;
+				} else
+					i++;
+			}
+
+			return wildcards;
+		}
+
+		/**
+		 * @returns The indices into the suffix array of all suffixes starting with bytes
+		 */
+		[[nodiscard]] std::pair<std::size_t, std::size_t> find_suffixes(std::span<const std::byte> bytes) const
+		{
+			const auto prefix = [this, &bytes](std::int32_t suffix) {
+				return module.subspan(suffix, std::min(bytes.size(), module.size() - suffix));
+			};
+			const auto compare = [](std::span<const std::byte> lhs, std::span<const std::byte> rhs) {
+				return std::ranges::lexicographical_compare(lhs, rhs);
+			};
+
+			auto [begin, end] = std::ranges::equal_range(suffix_array, bytes, compare, prefix);
+			return { begin - suffix_array.begin(), end - suffix_array.begin() };
+		}
+
+		[[nodiscard]] bool is_unique(const std::vector<PatternElement>& elements) const
+		{
+			// Look up every run of concrete bytes and then verify the occurrences of the rarest one,
+			// the pattern can't occur more often than that.
+			std::size_t anchor_offset = 0;
+			std::pair<std::size_t, std::size_t> anchor{ 0, suffix_array.size() };
+
+			std::vector<std::byte> run;
+			for (std::size_t i = 0; i <= elements.size(); i++) {
+				if (i < elements.size() && elements[i].has_value()) {
+					run.push_back(elements[i].value());
+					continue;
+				}
+				if (run.empty())
+					continue;
+
+				auto suffixes = find_suffixes(run);
+				if (suffixes.second - suffixes.first < anchor.second - anchor.first) {
+					anchor = suffixes;
+					anchor_offset = i - run.size();
+				}
+				run.clear();
+			}
+
+			if (anchor.second - anchor.first <= 1)
+				return true;
+
+			std::size_t count = 0;
+			for (std::size_t i = anchor.first; i < anchor.second; i++) {
+				const auto suffix = static_cast<std::size_t>(suffix_array[i]);
+				if (suffix < anchor_offset)
+					continue;
+				const std::size_t start = suffix - anchor_offset;
+				if (module.size() - start < elements.size())
+					continue;
+
+				const auto candidate = module.subspan(start, elements.size());
+				if (std::ranges::equal(candidate, elements, detail::pattern_compare<std::byte>))
+					if (++count > 1)
+						return false;
+			}
+			return true;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SIGNATURESCANNER_TILEDSCAN_HPP
+#define SIGNATURESCANNER_TILEDSCAN_HPP
+
+#include "detail/ChunkedSearch.hpp"
+#include "detail/SignatureConcept.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner {
+	/**
+	 * Searches the first match of many signatures in the same region.
+	 * The region is split into blocks which fit into the L2 cache and every signature that has no match yet is searched in a block,
+	 * before the next one is loaded. Compared to searching the signatures one after another, the region is read from memory only once.
+	 * Signatures of different types can be mixed.
+	 */
+	class TiledScan {
+		std::size_t block_size;
+		std::vector<detail::ErasedSignature> signatures;
+
+	public:
+		static constexpr std::size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+		explicit TiledScan(std::size_t block_size = DEFAULT_BLOCK_SIZE)
+			: block_size(std::max<std::size_t>(block_size, 1))
+		{
+		}
+
+		/**
+		 * @returns The index of the signature in the results of scan
+		 */
+		template <detail::ContiguousSignature Sig>
+		std::size_t add(Sig signature)
+		{
+			signatures.emplace_back(std::move(signature));
+			return signatures.size() - 1;
+		}
+
+		/**
+		 * @returns The first match of every signature, in the order in which they were added, the end of the region if there is none
+		 */
+		[[nodiscard]] std::vector<const std::byte*> scan(std::span<const std::byte> region) const
+		{
+			const std::byte* region_end = region.data() + region.size();
+			std::vector<const std::byte*> matches(signatures.size(), region_end);
+
+			// Indices of the signatures that haven't matched yet
+			std::vector<std::size_t> pending(signatures.size());
+			for (std::size_t i = 0; i < pending.size(); i++)
+				pending[i] = i;
+
+			for (std::size_t offset = 0; offset < region.size() && !pending.empty(); offset += block_size) {
+				const std::byte* block_begin = region.data() + offset;
+				const std::byte* block_end = region.data() + std::min(region.size(), offset + block_size);
+
+				std::erase_if(pending, [&](std::size_t i) {
+					const detail::ErasedSignature& signature = signatures[i];
+					const std::size_t overlap = detail::chunk_overlap(signature.match_length);
+					const std::byte* end = static_cast<std::size_t>(region_end - block_end) < overlap ? region_end : block_end + overlap;
+
+					const std::byte* match = signature.next(block_begin, end);
+					if (match >= block_end)
+						return false;
+					matches[i] = match;
+					return true;
+				});
+			}
+			return matches;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef SIGNATURESCANNER_TRACKEDREGION_HPP
+#define SIGNATURESCANNER_TRACKEDREGION_HPP
+
+#include "detail/ChunkedSearch.hpp"
+#include "detail/SignatureConcept.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner {
+	/**
+	 * Keeps the matches of signatures in a region up to date, while the region is modified (e.g. by hooks or trampolines).
+	 * Every page is hashed, refreshing only searches again where a changed page may have created or destroyed a match.
+	 * The region is not copied, it must not be modified while it is scanned.
+	 */
+	class TrackedRegion {
+		struct Tracked {
+			detail::ErasedSignature signature;
+			std::vector<const std::byte*> matches;
+		};
+
+		std::span<const std::byte> region;
+		std::size_t page_size;
+		std::vector<std::size_t> page_hashes;
+		std::vector<Tracked> signatures;
+
+		[[nodiscard]] std::size_t hash_page(std::size_t page) const
+		{
+			const std::span<const std::byte> bytes = region.subspan(page * page_size, std::min(page_size, region.size() - page * page_size));
+			return std::hash<std::string_view>{}({ reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+		}
+
+		/**
+		 * Replaces the matches of tracked, which start in [from, to)
+		 */
+		void scan(Tracked& tracked, std::size_t from, std::size_t to) const
+		{
+			const std::byte* begin = region.data() + from;
+			const std::byte* limit = region.data() + to;
+			// Matches starting in front of limit may continue behind it
+			const std::byte* end = region.data() + std::min(region.size(), to + detail::chunk_overlap(tracked.signature.match_length));
+
+			std::vector<const std::byte*> found;
+			for (const std::byte* it = begin; it < limit;) {
+				const std::byte* match = tracked.signature.next(it, end);
+				if (match >= limit)
+					break;
+				found.push_back(match);
+				it = match + 1;
+			}
+
+			const auto first = std::ranges::lower_bound(tracked.matches, begin);
+			const auto last = std::ranges::lower_bound(tracked.matches, limit);
+			tracked.matches.insert(tracked.matches.erase(first, last), found.begin(), found.end());
+		}
+
+	public:
+		static constexpr std::size_t DEFAULT_PAGE_SIZE = 4096;
+
+		explicit TrackedRegion(std::span<const std::byte> region, std::size_t page_size = DEFAULT_PAGE_SIZE)
+			: region(region)
+			, page_size(std::max<std::size_t>(page_size, 1))
+		{
+			page_hashes.resize((region.size() + this->page_size - 1) / this->page_size);
+			for (std::size_t page = 0; page < page_hashes.size(); page++)
+				page_hashes[page] = hash_page(page);
+		}
+
+		[[nodiscard]] std::span<const std::byte> get_region() const { return region; }
+		[[nodiscard]] std::size_t get_page_size() const { return page_size; }
+
+		/**
+		 * Searches the whole region for signature and keeps its matches up to date from now on.
+		 * @returns The id of the signature, used to retrieve the matches
+		 */
+		template <detail::ContiguousSignature Sig>
+		std::size_t track(Sig signature)
+		{
+			Tracked& tracked = signatures.emplace_back(detail::ErasedSignature{ std::move(signature) }, std::vector<const std::byte*>{});
+			scan(tracked, 0, region.size());
+			return signatures.size() - 1;
+		}
+
+		/**
+		 * @returns The matches of the signature with the given id in ascending order
+		 */
+		[[nodiscard]] std::span<const std::byte* const> get_matches(std::size_t id) const
+		{
+			return signatures[id].matches;
+		}
+
+		/**
+		 * Hashes all pages again and searches the changed ones.
+		 * @returns The amount of pages, which have changed since the last refresh
+		 */
+		std::size_t refresh()
+		{
+			// Runs of consecutive changed pages as byte offsets
+			std::vector<std::pair<std::size_t, std::size_t>> changes;
+			std::size_t changed_pages = 0;
+			for (std::size_t page = 0; page < page_hashes.size(); page++) {
+				const std::size_t hash = hash_page(page);
+				if (hash == page_hashes[page])
+					continue;
+				page_hashes[page] = hash;
+				changed_pages++;
+
+				const std::size_t begin = page * page_size;
+				const std::size_t end = std::min(region.size(), begin + page_size);
+				if (!changes.empty() && changes.back().second == begin)
+					changes.back().second = end;
+				else
+					changes.emplace_back(begin, end);
+			}
+
+			for (Tracked& tracked : signatures) {
+				// Matches starting up to match_length - 1 bytes in front of a change contain changed bytes as well
+				const std::size_t overlap = detail::chunk_overlap(tracked.signature.match_length);
+				std::size_t from = 0;
+				std::size_t to = 0;
+				for (const auto& [begin, end] : changes) {
+					const std::size_t extended_begin = begin - std::min(begin, overlap);
+					if (to != 0 && extended_begin <= to) {
+						to = end;
+						continue;
+					}
+					if (to != 0)
+						scan(tracked, from, to);
+					from = extended_begin;
+					to = end;
+				}
+				if (to != 0)
+					scan(tracked, from, to);
+			}
+
+			return changed_pages;
+		}
+	};
+}
+
+#endif
@@ -2,20 +2,26 @@
 #define SIGNATURESCANNER_XREFSIGNATURE_HPP
 
 #include "detail/ByteConverter.hpp"
+#include "detail/SegmentedSearch.hpp"
 #include "detail/SignatureConcept.hpp"
+#include "detail/X86Prefilter.hpp"
+#include "detail/X86Reference.hpp"
 
+#include <algorithm>
 #include <bit>
 #include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <optional>
 #include <type_traits>
 
 namespace SignatureScanner {
-	class XRefTypes : public std::bitset<2> {
+	class XRefTypes : public std::bitset<3> {
 		enum Index : std::uint8_t {
 			RELATIVE = 0,
-			ABSOLUTE = 1
+			ABSOLUTE = 1,
+			INSTRUCTION_RELATIVE = 2
 		};
 
 	public:
@@ -29,6 +35,11 @@ namespace SignatureScanner {
 			return test(ABSOLUTE);
 		}
 
+		[[nodiscard]] constexpr bool is_instruction_relative() const
+		{
+			return test(INSTRUCTION_RELATIVE);
+		}
+
 		constexpr static XRefTypes relative()
 		{
 			XRefTypes types;
@@ -52,6 +63,28 @@ namespace SignatureScanner {
 			types.set(ABSOLUTE, true);
 			return types;
 		}
+
+		/**
+		 * Instead of treating every offset as a possible rel32, only the displacements of x86-64 instructions that are
+		 * known to reference code or data are considered (see detail::decode_x86_reference).
+		 * The instruction length is derived from the instruction itself and matches always point at the opcode of the instruction,
+		 * prefixes (e.g. the REX prefix of 48 8D 05) come in front of the match.
+		 * An operand-size prefix that shrinks the immediate of cmp/mov is only recognized if it is part of the searched range.
+		 */
+		constexpr static XRefTypes instruction_relative()
+		{
+			XRefTypes types;
+			types.set(INSTRUCTION_RELATIVE, true);
+			return types;
+		}
+
+		constexpr static XRefTypes instruction_relative_and_absolute()
+		{
+			XRefTypes types;
+			types.set(ABSOLUTE, true);
+			types.set(INSTRUCTION_RELATIVE, true);
+			return types;
+		}
 	};
 
 	class XRefSignature {
@@ -61,22 +94,106 @@ namespace SignatureScanner {
 
 		const std::uintptr_t address;
 		const bool absolute;
+		const bool instruction_relative;
 		const std::uint8_t instruction_length; // If instruction_length == 0 then relative search is disabled
 
 	public:
 		explicit constexpr XRefSignature(XRefTypes types, std::uintptr_t address, std::uint8_t instruction_length = 4)
 			: address(address)
 			, absolute(types.is_absolute())
+			, instruction_relative(types.is_instruction_relative())
 			, instruction_length(types.is_relative() ? instruction_length : 0)
 		{
 		}
 
 	private:
 #ifdef SIGNATURESCANNER_OPTIMIZE
+		// These call the contiguous search functions, but in an optimized translation unit.
 		const std::byte* optimized_next(const std::byte* it, const std::byte* end, std::uintptr_t location) const;
 		const std::byte* optimized_prev(const std::byte* it, const std::byte* end, std::uintptr_t location) const;
 #endif
 
+		const std::byte* contiguous_next(const std::byte* it, const std::byte* end, std::uintptr_t location) const
+		{
+#ifdef SIGNATURESCANNER_OPTIMIZE
+			return optimized_next(it, end, location);
+#else
+			return search_contiguous(it, end, location);
+#endif
+		}
+
+		// Whether there is an operand-size prefix in front of the opcode at it, bytes in front of first are not inspected
+		[[nodiscard]] bool has_operand_size_prefix(const std::byte* first, const std::byte* it) const
+		{
+			if (!is_instruction_relative())
+				return false;
+			const auto byte_before = [first, it](std::ptrdiff_t n) -> std::optional<std::uint8_t> {
+				if (it - first < n)
+					return std::nullopt;
+				return std::to_integer<std::uint8_t>(it[-n]);
+			};
+			return detail::has_operand_size_prefix(byte_before(1), byte_before(2));
+		}
+
+		const std::byte* search_contiguous(const std::byte* it, const std::byte* end, std::uintptr_t location) const
+		{
+			const std::byte* first = it;
+			// The prefilter is only useful if there is no search mode which has to inspect every single offset.
+			if (is_instruction_relative() && !is_absolute() && !is_relative()) {
+#ifdef __SSE2__
+				while (end - it >= static_cast<std::ptrdiff_t>(detail::X86_PREFILTER_WIDTH + detail::X86_PREFILTER_LOOKAHEAD)) {
+					std::uint32_t candidates = detail::x86_reference_candidates(it);
+					while (candidates != 0) {
+						const int idx = std::countr_zero(candidates);
+						if (does_match(it + idx, end, location + idx, has_operand_size_prefix(first, it + idx)))
+							return it + idx;
+						candidates &= candidates - 1;
+					}
+					it += detail::X86_PREFILTER_WIDTH;
+					location += detail::X86_PREFILTER_WIDTH;
+				}
+#endif
+				for (; end - it > static_cast<std::ptrdiff_t>(detail::X86_PREFILTER_LOOKAHEAD); it++, location++)
+					if (detail::may_be_x86_reference(it) && does_match(it, end, location, has_operand_size_prefix(first, it)))
+						return it;
+			}
+
+			for (; it != end; it++)
+				if (does_match(it, end, location++, has_operand_size_prefix(first, it)))
+					return it;
+			return it;
+		}
+
+		const std::byte* search_contiguous_reverse(const std::byte* it, const std::byte* end, std::uintptr_t location) const
+		{
+			// end is the byte in front of the searched range
+			for (; it != end; it--)
+				if (does_match(it, end, location--, has_operand_size_prefix(end + 1, it)))
+					return it;
+			return it;
+		}
+
+		template <std::input_iterator Iter>
+		[[nodiscard]] constexpr bool does_match(const Iter& iter, const std::sentinel_for<Iter> auto& end, std::uintptr_t location, bool operand_size_prefix) const
+		{
+			if (is_absolute())
+				if (auto bytes = detail::convert_bytes<std::uintptr_t>(iter, end))
+					if (does_absolute_match(bytes.value()))
+						return true;
+
+			if (is_relative())
+				if (auto bytes = detail::convert_bytes<RelAddrType>(iter, end))
+					if (does_relative_match(bytes.value(), location))
+						return true;
+
+			if (is_instruction_relative())
+				if (auto reference = detail::decode_x86_reference(iter, end, operand_size_prefix))
+					if (does_instruction_match(reference.value(), location))
+						return true;
+
+			return false;
+		}
+
 	public:
 		template <std::input_iterator Iter, std::sentinel_for<Iter> Sent>
 		[[nodiscard]] constexpr Iter next(Iter it, const Sent& end) const
@@ -105,18 +222,32 @@ namespace SignatureScanner {
 		template <std::input_iterator Iter, std::sentinel_for<Iter> Sent>
 		[[nodiscard]] constexpr Iter next(Iter it, const Sent& end, std::uintptr_t location) const
 		{
-#ifdef SIGNATURESCANNER_OPTIMIZE
 			if constexpr (std::contiguous_iterator<Iter> && std::contiguous_iterator<Sent> && sizeof(std::iter_value_t<Iter>) == 1) {
-				const auto* it_ptr = reinterpret_cast<const std::byte*>(std::to_address(it));
-				const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+				if !consteval {
+					const auto* it_ptr = reinterpret_cast<const std::byte*>(std::to_address(it));
+					const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
 
-				auto match_dist = optimized_next(it_ptr, end_ptr, location) - it_ptr;
-				return std::next(it, match_dist);
+					auto match_dist = contiguous_next(it_ptr, end_ptr, location) - it_ptr;
+					return std::next(it, match_dist);
+				}
 			}
-#endif
-			for (; it != end; it++)
-				if (does_match(it, end, location++))
+			if constexpr (detail::SegmentedIterator<Iter, Sent>) {
+				return detail::segmented_next(
+					it, end, get_match_length(), location,
+					[this](const auto* segment_begin, const auto* segment_end, std::uintptr_t segment_location) { return next(segment_begin, segment_end, segment_location); },
+					[this](const Iter& candidate, const Sent& sent, std::uintptr_t candidate_location) { return does_match(candidate, sent, candidate_location); });
+			}
+			// The two bytes in front of it, which may be an operand-size prefix
+			std::optional<std::uint8_t> previous;
+			std::optional<std::uint8_t> before_previous;
+			for (; it != end; it++) {
+				if (does_match(it, end, location++, detail::has_operand_size_prefix(previous, before_previous)))
 					return it;
+				if (is_instruction_relative()) {
+					before_previous = previous;
+					previous = detail::convert_bytes<std::uint8_t>(it, end);
+				}
+			}
 
 			return it;
 		}
@@ -125,14 +256,19 @@ namespace SignatureScanner {
 		[[nodiscard]] constexpr Iter prev(Iter it, const Sent& end, std::uintptr_t location) const
 		{
 #ifdef SIGNATURESCANNER_OPTIMIZE
+			// The optimized version walks downwards from it, header-only it is searched like any other range
 			if constexpr (std::contiguous_iterator<Iter> && std::contiguous_iterator<Sent> && sizeof(std::iter_value_t<Iter>) == 1) {
-				const auto* it_ptr = reinterpret_cast<const std::byte*>(std::to_address(it));
-				const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
+				if !consteval {
+					const auto* it_ptr = reinterpret_cast<const std::byte*>(std::to_address(it));
+					const auto* end_ptr = reinterpret_cast<const std::byte*>(std::to_address(end));
 
-				auto match_dist = optimized_prev(it_ptr, end_ptr, location) - it_ptr;
-				return std::next(it, match_dist);
+					auto match_dist = optimized_prev(it_ptr, end_ptr, location) - it_ptr;
+					return std::next(it, match_dist);
+				}
 			}
 #endif
+			// The bytes are read in the opposite direction, that ends where the search started
+			const auto read_end = std::make_reverse_iterator(it);
 			for (; it != end; it++) {
 				// Regarding the "- 1":
 				// ```
@@ -141,27 +277,25 @@ namespace SignatureScanner {
 				// a one-past-the-end iterator dereferences to the last element in a sequence.
 				// ```
 				// https://en.cppreference.com/w/cpp/iterator/reverse_iterator
-				if (does_match(std::make_reverse_iterator(it) - 1, std::make_reverse_iterator(end) - 1, location--))
+				bool operand_size_prefix = false;
+				if (is_instruction_relative()) {
+					// The bytes in front of the opcode come after it in this direction
+					const Iter previous = std::next(it);
+					const Iter before_previous = previous == end ? previous : std::next(previous);
+					operand_size_prefix = detail::has_operand_size_prefix(detail::convert_bytes<std::uint8_t>(previous, end), detail::convert_bytes<std::uint8_t>(before_previous, end));
+				}
+				if (does_match(std::make_reverse_iterator(it) - 1, read_end, location--, operand_size_prefix))
 					return it;
 			}
 
 			return it;
 		}
 
+		// Nothing in front of iter is inspected, so instructions are assumed to have no operand-size prefix
 		template <std::input_iterator Iter>
 		[[nodiscard]] constexpr bool does_match(const Iter& iter, const std::sentinel_for<Iter> auto& end, std::uintptr_t location) const
 		{
-			if (is_absolute())
-				if (auto bytes = detail::convert_bytes<std::uintptr_t>(iter, end))
-					if (does_absolute_match(bytes.value()))
-						return true;
-
-			if (is_relative())
-				if (auto bytes = detail::convert_bytes<RelAddrType>(iter, end))
-					if (does_relative_match(bytes.value(), location))
-						return true;
-
-			return false;
+			return does_match(iter, end, location, false);
 		}
 
 		[[nodiscard]] constexpr bool does_match(std::uintptr_t number, std::uintptr_t location) const
@@ -180,6 +314,7 @@ namespace SignatureScanner {
 		template <std::input_iterator Iter>
 		constexpr void all(Iter begin, const std::sentinel_for<Iter> auto& end, std::output_iterator<Iter> auto inserter, std::uintptr_t location) const
 		{
+			const std::uintptr_t begin_location = location;
 			Iter current = begin;
 			while (true) {
 				auto it = this->next(current, end, location);
@@ -187,9 +322,15 @@ namespace SignatureScanner {
 					break;
 				*inserter++ = it;
 
-				location += std::distance(current, it) + 1;
-				current = it;
-				current++;
+				if constexpr (detail::SegmentedIterator<Iter, std::remove_cvref_t<decltype(end)>>) {
+					current = std::next(it);
+					// The segments may have gaps between them, so the distance to begin is taken from the real addresses
+					location = begin_location + (reinterpret_cast<std::uintptr_t>(std::to_address(current)) - reinterpret_cast<std::uintptr_t>(std::to_address(begin)));
+				} else {
+					location += std::distance(current, it) + 1;
+					current = it;
+					current++;
+				}
 			}
 		}
 
@@ -203,6 +344,24 @@ namespace SignatureScanner {
 			return instruction_length > 0;
 		}
 
+		[[nodiscard]] constexpr bool is_instruction_relative() const
+		{
+			return instruction_relative;
+		}
+
+		// Amount of bytes that have to be inspected to decide if there is a match
+		[[nodiscard]] constexpr std::size_t get_match_length() const
+		{
+			std::size_t length = 0;
+			if (is_absolute())
+				length = std::max(length, sizeof(std::uintptr_t));
+			if (is_relative())
+				length = std::max(length, sizeof(RelAddrType));
+			if (is_instruction_relative())
+				length = std::max(length, detail::X86_REFERENCE_READ_LENGTH);
+			return length;
+		}
+
 		[[nodiscard]] constexpr bool does_absolute_match(std::uintptr_t number) const
 		{
 			return number == address;
@@ -217,6 +376,11 @@ namespace SignatureScanner {
 				return false;
 			return location + instruction_length + offset == address;
 		}
+
+		[[nodiscard]] constexpr bool does_instruction_match(const detail::X86Reference& reference, std::uintptr_t location) const
+		{
+			return location + reference.instruction_length + reference.displacement == address;
+		}
 	};
 
 	static_assert(detail::Signature<XRefSignature>);
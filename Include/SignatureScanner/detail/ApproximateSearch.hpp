@@ -0,0 +1,79 @@
+#ifndef SIGNATURESCANNER_DETAIL_APPROXIMATESEARCH_HPP
+#define SIGNATURESCANNER_DETAIL_APPROXIMATESEARCH_HPP
+
+#include "PatternParser.hpp"
+#include "PatternSearch.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Mismatch counting for PatternSignature::approximate, which compares 8 bytes of the pattern at once.
+
+namespace SignatureScanner::detail {
+	// A pattern of any length split into words of 8 elements
+	struct PackedPattern {
+		std::vector<PatternWord> words;
+		std::size_t length;
+	};
+
+	struct ApproximateHit {
+		std::size_t offset;
+		std::size_t distance;
+	};
+
+	inline PackedPattern pack_pattern(std::span<const PatternElement> elements)
+	{
+		PackedPattern packed{ {}, elements.size() };
+		for (std::size_t offset = 0; offset < elements.size(); offset += sizeof(std::uint64_t))
+			packed.words.push_back(pack_word(elements, offset));
+		return packed;
+	}
+
+	// Amount of bytes in word that are not zero
+	inline std::size_t count_nonzero_bytes(std::uint64_t word)
+	{
+		constexpr std::uint64_t LOW_BITS = 0x7F7F7F7F7F7F7F7F;
+		// The high bit of every byte is set if any of its lower bits is set or if it was set already, this can't carry into the next byte
+		const std::uint64_t high_bits = ((word & LOW_BITS) + LOW_BITS) | word;
+		return std::popcount(high_bits & ~LOW_BITS);
+	}
+
+	/**
+	 * Counts the mismatching bytes of the pattern at it, but stops as soon as there are more than max_mismatches.
+	 * pattern.length bytes have to be readable at it.
+	 */
+	inline std::size_t approximate_distance(const std::byte* it, const PackedPattern& pattern, std::size_t max_mismatches)
+	{
+		std::size_t distance = 0;
+		for (std::size_t word = 0; word < pattern.words.size(); word++) {
+			const std::size_t offset = word * sizeof(std::uint64_t);
+			const std::uint64_t bytes = load_little_endian(it + offset, std::min(pattern.length - offset, sizeof(std::uint64_t)));
+
+			distance += count_nonzero_bytes((bytes ^ pattern.words[word].value) & pattern.words[word].mask);
+			if (distance > max_mismatches)
+				break;
+		}
+		return distance;
+	}
+
+	inline void find_approximate(const std::byte* begin, const std::byte* end, const PackedPattern& pattern, std::size_t max_mismatches, std::vector<ApproximateHit>& hits)
+	{
+		// Matches start in front of end, even if the pattern is empty
+		const std::size_t length = std::max<std::size_t>(pattern.length, 1);
+		if (static_cast<std::size_t>(end - begin) < length)
+			return;
+
+		const std::byte* last = end - length;
+		for (const std::byte* it = begin; it <= last; it++) {
+			const std::size_t distance = approximate_distance(it, pattern, max_mismatches);
+			if (distance <= max_mismatches)
+				hits.push_back({ static_cast<std::size_t>(it - begin), distance });
+		}
+	}
+}
+
+#endif
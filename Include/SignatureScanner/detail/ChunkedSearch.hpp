@@ -0,0 +1,34 @@
+#ifndef SIGNATURESCANNER_DETAIL_CHUNKEDSEARCH_HPP
+#define SIGNATURESCANNER_DETAIL_CHUNKEDSEARCH_HPP
+
+#include "SignatureConcept.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+// Helpers for scanners which split a region into chunks and search them separately.
+
+namespace SignatureScanner::detail {
+	// Matches starting in a chunk may reach this many bytes into the next one, so these have to be searched with the chunk
+	constexpr std::size_t chunk_overlap(std::size_t match_length)
+	{
+		return std::max<std::size_t>(match_length, 1) - 1;
+	}
+
+	// Signatures of different types, which are kept in the same container
+	struct ErasedSignature {
+		std::size_t match_length;
+		std::function<const std::byte*(const std::byte*, const std::byte*)> next;
+
+		template <ContiguousSignature Sig>
+		explicit ErasedSignature(Sig signature)
+			: match_length(signature.get_match_length())
+			, next([signature = std::move(signature)](const std::byte* begin, const std::byte* end) { return signature.next(begin, end); })
+		{
+		}
+	};
+}
+
+#endif
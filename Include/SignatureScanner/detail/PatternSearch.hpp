@@ -0,0 +1,155 @@
+#ifndef SIGNATURESCANNER_DETAIL_PATTERNSEARCH_HPP
+#define SIGNATURESCANNER_DETAIL_PATTERNSEARCH_HPP
+
+#include "PatternParser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <span>
+
+// Search functions for contiguous bytes.
+// Everything except find_pattern and find_pattern_reverse, which rely on memchr, can be used in constant evaluation.
+
+namespace SignatureScanner::detail {
+	// Bytes that are used for padding in code and data, these are very frequent and say little about a match
+	constexpr bool is_padding_byte(std::byte byte)
+	{
+		return byte == std::byte{ 0x00 } || byte == std::byte{ 0xCC } || byte == std::byte{ 0x90 } || byte == std::byte{ 0xFF };
+	}
+
+	/**
+	 * Chooses the concrete byte that is used to find candidates.
+	 * Padding bytes are avoided if possible.
+	 * @returns The offset of the byte in the pattern, elements.size() if there is no concrete byte
+	 */
+	constexpr std::size_t choose_anchor(std::span<const PatternElement> elements)
+	{
+		std::size_t anchor = elements.size();
+		for (std::size_t i = 0; i < elements.size(); i++) {
+			if (!elements[i].has_value())
+				continue;
+			if (!is_padding_byte(elements[i].value()))
+				return i;
+			if (anchor == elements.size())
+				anchor = i;
+		}
+		return anchor;
+	}
+
+	/**
+	 * Up to 8 elements of a pattern as a little-endian word, so the first element is the lowest byte.
+	 * Wildcards and the bytes behind the pattern are cleared in the mask.
+	 */
+	struct PatternWord {
+		std::uint64_t value = 0;
+		std::uint64_t mask = 0;
+	};
+
+	constexpr PatternWord pack_word(std::span<const PatternElement> elements, std::size_t offset)
+	{
+		PatternWord word;
+		for (std::size_t i = 0; i < sizeof(std::uint64_t) && offset + i < elements.size(); i++) {
+			if (!elements[offset + i].has_value())
+				continue;
+			word.value |= std::uint64_t{ std::to_integer<std::uint8_t>(elements[offset + i].value()) } << (i * 8);
+			word.mask |= std::uint64_t{ 0xFF } << (i * 8);
+		}
+		return word;
+	}
+
+	// Same as convert_bytes, but without the bounds check. Only length bytes are read, the remaining bytes of the word are zero.
+	constexpr std::uint64_t load_little_endian(const std::byte* it, std::size_t length = sizeof(std::uint64_t))
+	{
+		std::uint64_t word = 0;
+		if consteval {
+			for (std::size_t i = 0; i < length; i++)
+				word |= std::uint64_t{ std::to_integer<std::uint8_t>(it[i]) } << (i * 8);
+		} else {
+			std::memcpy(&word, it, length);
+			if constexpr (std::endian::little != std::endian::native)
+				word = std::byteswap(word);
+		}
+		return word;
+	}
+
+	// Patterns up to this length are compared as two words instead of element by element
+	constexpr std::size_t SHORT_PATTERN_LENGTH = 2 * sizeof(std::uint64_t);
+
+	struct ShortPattern {
+		std::array<PatternWord, 2> words{};
+		std::size_t word_count = 0;
+	};
+
+	constexpr ShortPattern pack_short_pattern(std::span<const PatternElement> elements)
+	{
+		ShortPattern packed;
+		packed.word_count = elements.size() > sizeof(std::uint64_t) ? 2 : 1;
+		for (std::size_t word = 0; word < packed.word_count; word++)
+			packed.words[word] = pack_word(elements, word * sizeof(std::uint64_t));
+		return packed;
+	}
+
+	/**
+	 * All words of the pattern have to be readable at it
+	 */
+	constexpr bool short_pattern_matches(const std::byte* it, const ShortPattern& pattern)
+	{
+		const auto word_matches = [&](std::size_t word) {
+			return ((load_little_endian(it + word * sizeof(std::uint64_t)) ^ pattern.words[word].value) & pattern.words[word].mask) == 0;
+		};
+		return word_matches(0) && (pattern.word_count == 1 || word_matches(1));
+	}
+
+	/**
+	 * Finds candidates with memchr (which is vectorized by every common libc) and then compares the whole pattern.
+	 */
+	inline const std::byte* find_pattern(const std::byte* begin, const std::byte* end, std::span<const PatternElement> elements)
+	{
+		const std::size_t length = elements.size();
+		if (static_cast<std::size_t>(end - begin) < length)
+			return end;
+
+		const std::size_t anchor = choose_anchor(elements);
+		if (anchor == length)
+			return begin; // Only wildcards, this matches everywhere
+
+		const auto anchor_byte = std::to_integer<unsigned char>(elements[anchor].value());
+		const std::byte* last = end - length;
+
+		const bool is_short = length <= SHORT_PATTERN_LENGTH;
+		const ShortPattern short_pattern = is_short ? pack_short_pattern(elements) : ShortPattern{};
+		const std::size_t word_bytes = short_pattern.word_count * sizeof(std::uint64_t);
+
+		for (const std::byte* it = begin; it <= last;) {
+			const void* found = std::memchr(it + anchor, anchor_byte, static_cast<std::size_t>(last - it) + 1);
+			if (found == nullptr)
+				break;
+
+			const std::byte* candidate = static_cast<const std::byte*>(found) - anchor;
+			// The words can only be loaded if they don't reach behind end
+			if (is_short && static_cast<std::size_t>(end - candidate) >= word_bytes) {
+				if (short_pattern_matches(candidate, short_pattern))
+					return candidate;
+			} else if (std::equal(elements.begin(), elements.end(), candidate, [](const PatternElement& elem, std::byte byte) { return pattern_compare(byte, elem); }))
+				return candidate;
+			it = candidate + 1;
+		}
+		return end;
+	}
+
+	inline const std::byte* find_pattern_reverse(const std::byte* begin, const std::byte* end, std::span<const PatternElement> elements)
+	{
+		auto rbegin = std::make_reverse_iterator(begin);
+		auto rend = std::make_reverse_iterator(end);
+		auto match = std::ranges::search(rbegin, rend, elements.rbegin(), elements.rend(), pattern_compare<std::byte>).end();
+		return std::to_address(match);
+	}
+}
+
+#endif
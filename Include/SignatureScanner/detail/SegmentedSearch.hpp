@@ -0,0 +1,61 @@
+#ifndef SIGNATURESCANNER_DETAIL_SEGMENTEDSEARCH_HPP
+#define SIGNATURESCANNER_DETAIL_SEGMENTEDSEARCH_HPP
+
+#include "ChunkedSearch.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+
+namespace SignatureScanner::detail {
+	template <typename Iter, typename Sent>
+	concept SegmentedIterator = std::forward_iterator<Iter> && requires(const Iter it, const Sent end, std::size_t n) {
+		{ it.remaining_segment(end) } -> std::ranges::contiguous_range;
+		{ it.advanced_in_segment(n) } -> std::same_as<Iter>;
+	};
+
+	/**
+	 * Runs search on every contiguous segment in [it, end).
+	 * Matches beginning in the last match_length - 1 bytes of a segment may continue in the next segments,
+	 * so these positions are checked with does_match on the segmented iterators instead.
+	 * The location is the one of the first byte, the bytes of the following segments keep the same distance to their real addresses.
+	 * This way gaps between segments are respected by searches that depend on the location.
+	 */
+	template <typename Iter, typename Sent>
+		requires SegmentedIterator<Iter, Sent>
+	constexpr Iter segmented_next(Iter it, const Sent& end, std::size_t match_length, std::uintptr_t location, const auto& search, const auto& does_match)
+	{
+		if (it == end)
+			return it;
+		const std::uintptr_t location_offset = location - reinterpret_cast<std::uintptr_t>(std::ranges::data(it.remaining_segment(end)));
+		const auto location_of = [location_offset](const auto* byte) { return reinterpret_cast<std::uintptr_t>(byte) + location_offset; };
+
+		while (it != end) {
+			auto segment = it.remaining_segment(end);
+			const auto* segment_begin = std::ranges::data(segment);
+			const auto* segment_end = segment_begin + std::ranges::size(segment);
+
+			// If the segment ends at end, then there is nothing a match could continue into.
+			Iter segment_last = it.advanced_in_segment(std::ranges::size(segment) - 1);
+			const bool is_last = std::next(segment_last) == end;
+			const std::size_t tail = is_last ? 0 : std::min(chunk_overlap(match_length), std::ranges::size(segment));
+
+			const auto* match = search(segment_begin, segment_end, location_of(segment_begin));
+			if (match < segment_end - tail)
+				return it.advanced_in_segment(match - segment_begin);
+
+			Iter candidate = it.advanced_in_segment(std::ranges::size(segment) - tail);
+			for (const auto* byte = segment_end - tail; byte != segment_end; byte++, candidate++)
+				if (does_match(candidate, end, location_of(byte)))
+					return candidate;
+
+			it = candidate;
+		}
+		return it;
+	}
+}
+
+#endif
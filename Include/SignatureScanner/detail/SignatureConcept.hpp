@@ -17,6 +17,13 @@ namespace SignatureScanner::detail {
 
 		{ signature.does_match(iterator, end) } -> std::convertible_to<bool>;
 	};
+
+	// Signatures that can be searched in contiguous bytes, which is all that the batch scanners need
+	template <typename T>
+	concept ContiguousSignature = requires(const T& signature, const std::byte* it) {
+		{ signature.next(it, it) } -> std::same_as<const std::byte*>;
+		{ signature.get_match_length() } -> std::convertible_to<std::size_t>;
+	};
 }
 
 #endif
@@ -0,0 +1,134 @@
+#ifndef SIGNATURESCANNER_DETAIL_SUFFIXARRAY_HPP
+#define SIGNATURESCANNER_DETAIL_SUFFIXARRAY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+namespace SignatureScanner::detail {
+	/**
+	 * Builds the suffix array of string using SA-IS, which runs in linear time and only needs a few integers per character.
+	 * All characters have to be in [0, upper].
+	 */
+	template <std::ranges::random_access_range String>
+	std::vector<std::int32_t> build_suffix_array(const String& string, std::int32_t upper)
+	{
+		const auto n = static_cast<std::int32_t>(std::ranges::size(string));
+		const auto chr = [&string](std::int32_t i) { return static_cast<std::int32_t>(string[i]); };
+
+		if (n == 0)
+			return {};
+		if (n == 1)
+			return { 0 };
+
+		std::vector<std::int32_t> sa(n);
+		if (n < 16) {
+			// Not worth the setup cost
+			std::iota(sa.begin(), sa.end(), 0);
+			std::ranges::sort(sa, [&](std::int32_t l, std::int32_t r) {
+				return std::ranges::lexicographical_compare(std::views::iota(l, n), std::views::iota(r, n), {}, chr, chr);
+			});
+			return sa;
+		}
+
+		// Types of the suffixes, S-type (true) if it is smaller than the following one, L-type (false) otherwise
+		std::vector<bool> ls(n);
+		for (std::int32_t i = n - 2; i >= 0; i--)
+			ls[i] = chr(i) == chr(i + 1) ? ls[i + 1] : chr(i) < chr(i + 1);
+
+		// Bucket boundaries, L-type suffixes are at the start of each bucket, S-type suffixes at the end
+		std::vector<std::int32_t> sum_l(upper + 1);
+		std::vector<std::int32_t> sum_s(upper + 1);
+		for (std::int32_t i = 0; i < n; i++)
+			if (!ls[i])
+				sum_s[chr(i)]++;
+			else
+				sum_l[chr(i) + 1]++;
+		for (std::int32_t i = 0; i <= upper; i++) {
+			sum_s[i] += sum_l[i];
+			if (i < upper)
+				sum_l[i + 1] += sum_s[i];
+		}
+
+		const auto induce = [&](const std::vector<std::int32_t>& lms) {
+			std::ranges::fill(sa, -1);
+			std::vector<std::int32_t> buf(sum_s);
+			for (std::int32_t d : lms)
+				if (d != n)
+					sa[buf[chr(d)]++] = d;
+
+			buf = sum_l;
+			sa[buf[chr(n - 1)]++] = n - 1;
+			for (std::int32_t i = 0; i < n; i++) {
+				const std::int32_t v = sa[i];
+				if (v >= 1 && !ls[v - 1])
+					sa[buf[chr(v - 1)]++] = v - 1;
+			}
+
+			buf = sum_l;
+			for (std::int32_t i = n - 1; i >= 0; i--) {
+				const std::int32_t v = sa[i];
+				if (v >= 1 && ls[v - 1])
+					sa[--buf[chr(v - 1) + 1]] = v - 1;
+			}
+		};
+
+		// Leftmost S-type suffixes, these are sorted recursively and then used to induce the order of all other suffixes
+		std::vector<std::int32_t> lms_map(n + 1, -1);
+		std::vector<std::int32_t> lms;
+		for (std::int32_t i = 1; i < n; i++)
+			if (!ls[i - 1] && ls[i]) {
+				lms_map[i] = static_cast<std::int32_t>(lms.size());
+				lms.push_back(i);
+			}
+		const auto m = static_cast<std::int32_t>(lms.size());
+
+		induce(lms);
+
+		if (m == 0)
+			return sa;
+
+		std::vector<std::int32_t> sorted_lms;
+		sorted_lms.reserve(m);
+		for (std::int32_t v : sa)
+			if (lms_map[v] != -1)
+				sorted_lms.push_back(v);
+
+		// Name the LMS substrings, equal substrings get the same name
+		std::vector<std::int32_t> reduced(m);
+		std::int32_t reduced_upper = 0;
+		reduced[lms_map[sorted_lms[0]]] = 0;
+		for (std::int32_t i = 1; i < m; i++) {
+			std::int32_t l = sorted_lms[i - 1];
+			std::int32_t r = sorted_lms[i];
+			const std::int32_t end_l = lms_map[l] + 1 < m ? lms[lms_map[l] + 1] : n;
+			const std::int32_t end_r = lms_map[r] + 1 < m ? lms[lms_map[r] + 1] : n;
+			bool same = true;
+			if (end_l - l != end_r - r)
+				same = false;
+			else {
+				while (l < end_l && chr(l) == chr(r)) {
+					l++;
+					r++;
+				}
+				if (l == n || chr(l) != chr(r))
+					same = false;
+			}
+			if (!same)
+				reduced_upper++;
+			reduced[lms_map[sorted_lms[i]]] = reduced_upper;
+		}
+
+		const std::vector<std::int32_t> reduced_sa = build_suffix_array(reduced, reduced_upper);
+		for (std::int32_t i = 0; i < m; i++)
+			sorted_lms[i] = lms[reduced_sa[i]];
+		induce(sorted_lms);
+
+		return sa;
+	}
+}
+
+#endif
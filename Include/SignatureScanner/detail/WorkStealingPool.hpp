@@ -0,0 +1,115 @@
+#ifndef SIGNATURESCANNER_DETAIL_WORKSTEALINGPOOL_HPP
+#define SIGNATURESCANNER_DETAIL_WORKSTEALINGPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace SignatureScanner::detail {
+	/**
+	 * Every worker has its own queue, idle workers steal from the other end of the queues of busy workers.
+	 * Tasks that are still queued when the pool is destroyed are executed before the threads are joined.
+	 */
+	class WorkStealingPool {
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::atomic<std::size_t> next_queue = 0;
+
+		std::mutex sleep_mutex;
+		std::condition_variable_any wakeup;
+		std::atomic<std::size_t> queued = 0;
+
+		// Has to be destroyed first, so that the threads are joined before anything else goes away
+		std::vector<std::jthread> threads;
+
+		std::optional<std::function<void()>> take(std::size_t self)
+		{
+			for (std::size_t i = 0; i < queues.size(); i++) {
+				Queue& queue = *queues[(self + i) % queues.size()];
+				const std::scoped_lock lock{ queue.mutex };
+				if (queue.tasks.empty())
+					continue;
+
+				std::function<void()> task;
+				if (i == 0) {
+					// Own queue, most recent task first
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+				} else {
+					task = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+				}
+				queued--;
+				return task;
+			}
+			return std::nullopt;
+		}
+
+		void work(const std::stop_token& stop_token, std::size_t self)
+		{
+			while (true) {
+				if (auto task = take(self)) {
+					(*task)();
+					continue;
+				}
+
+				std::unique_lock lock{ sleep_mutex };
+				if (!wakeup.wait(lock, stop_token, [this] { return queued > 0; }) && queued == 0)
+					return;
+			}
+		}
+
+	public:
+		explicit WorkStealingPool(std::size_t thread_count)
+		{
+			thread_count = std::max<std::size_t>(thread_count, 1);
+			for (std::size_t i = 0; i < thread_count; i++)
+				queues.emplace_back(std::make_unique<Queue>());
+			for (std::size_t i = 0; i < thread_count; i++)
+				threads.emplace_back([this, i](const std::stop_token& stop_token) { work(stop_token, i); });
+		}
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		~WorkStealingPool()
+		{
+			for (std::jthread& thread : threads)
+				thread.request_stop();
+			threads.clear();
+		}
+
+		[[nodiscard]] std::size_t get_thread_count() const { return threads.size(); }
+
+		void submit(std::function<void()> task)
+		{
+			// Counted first, so that the counter can't drop below zero when the task is taken right away
+			{
+				const std::scoped_lock lock{ sleep_mutex };
+				queued++;
+			}
+			Queue& queue = *queues[next_queue++ % queues.size()];
+			{
+				const std::scoped_lock lock{ queue.mutex };
+				queue.tasks.push_back(std::move(task));
+			}
+			wakeup.notify_one();
+		}
+	};
+}
+
+#endif
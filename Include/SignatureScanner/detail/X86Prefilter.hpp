@@ -0,0 +1,54 @@
+#ifndef SIGNATURESCANNER_DETAIL_X86PREFILTER_HPP
+#define SIGNATURESCANNER_DETAIL_X86PREFILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Prefilters for decode_x86_reference on contiguous bytes, these can't be used in constant evaluation.
+
+namespace SignatureScanner::detail {
+	// Bytes that have to be readable behind a position, so that the prefilter can inspect it
+	constexpr std::size_t X86_PREFILTER_LOOKAHEAD = 1;
+
+	/**
+	 * Cheap check if an instruction understood by decode_x86_reference may start at it.
+	 * This has false positives, but never false negatives.
+	 */
+	inline bool may_be_x86_reference(const std::byte* it)
+	{
+		const auto b0 = std::to_integer<std::uint8_t>(it[0]);
+		const auto b1 = std::to_integer<std::uint8_t>(it[1]);
+
+		const bool call_or_jmp = (b0 & 0xFE) == 0xE8;
+		const bool jcc = b0 == 0x0F && (b1 & 0xF0) == 0x80;
+		const bool rip_relative = (b1 & 0xC7) == 0x05;
+		return call_or_jmp || jcc || rip_relative;
+	}
+
+#ifdef __SSE2__
+	constexpr std::size_t X86_PREFILTER_WIDTH = 16;
+
+	// Vectorized may_be_x86_reference for X86_PREFILTER_WIDTH positions at once, bit i corresponds to it + i
+	inline std::uint32_t x86_reference_candidates(const std::byte* it)
+	{
+		const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+		const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 1));
+
+		const auto masked_equals = [](__m128i bytes, char mask, char value) {
+			return _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8(mask)), _mm_set1_epi8(value));
+		};
+
+		const __m128i call_or_jmp = masked_equals(b0, static_cast<char>(0xFE), static_cast<char>(0xE8));
+		const __m128i jcc = _mm_and_si128(_mm_cmpeq_epi8(b0, _mm_set1_epi8(0x0F)), masked_equals(b1, static_cast<char>(0xF0), static_cast<char>(0x80)));
+		const __m128i rip_relative = masked_equals(b1, static_cast<char>(0xC7), 0x05);
+
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(call_or_jmp, jcc), rip_relative)));
+	}
+#endif
+}
+
+#endif
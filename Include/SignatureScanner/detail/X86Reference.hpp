@@ -0,0 +1,129 @@
+#ifndef SIGNATURESCANNER_DETAIL_X86REFERENCE_HPP
+#define SIGNATURESCANNER_DETAIL_X86REFERENCE_HPP
+
+#include "ByteConverter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+
+namespace SignatureScanner::detail {
+	// Opcode, ModRM and displacement, immediates are never read
+	constexpr std::size_t X86_REFERENCE_READ_LENGTH = 6;
+
+	struct X86Reference {
+		std::int32_t displacement;
+		// Length from the opcode to the end of the instruction, which is where the displacement is relative to
+		std::uint8_t instruction_length;
+		// Offset of the displacement from the opcode
+		std::uint8_t displacement_offset;
+	};
+
+	/**
+	 * Whether the bytes in front of an opcode shrink the immediate of cmp/mov r/m, imm32 to 16 bits.
+	 * previous is the byte directly in front of the opcode, bytes outside of the searched range are std::nullopt.
+	 */
+	constexpr bool has_operand_size_prefix(std::optional<std::uint8_t> previous, std::optional<std::uint8_t> before_previous)
+	{
+		if (previous == 0x66)
+			return true;
+		// The REX prefix has to come last, REX.W takes precedence over the operand-size prefix
+		return previous && (previous.value() & 0xF8) == 0x40 && before_previous == 0x66;
+	}
+
+	/**
+	 * Decodes the instruction with the opcode at iter, if it is one of the x86-64 instructions that usually refer to other code or data:
+	 * - call/jmp rel32 (E8/E9)
+	 * - jcc rel32 (0F 80 - 0F 8F)
+	 * - RIP-relative lea, mov and cmp
+	 * Decoding always starts at the opcode, since the displacement is relative to the end of the instruction,
+	 * prefixes don't change the referenced address.
+	 * The exception is the operand-size prefix in front of cmp/mov r/m, imm32 (e.g. 66 81 3D or 66 C7 05),
+	 * which shrinks the immediate to 16 bits, operand_size_prefix tells if there is one (see has_operand_size_prefix).
+	 */
+	template <std::input_iterator Iter>
+	constexpr std::optional<X86Reference> decode_x86_reference(Iter iter, const std::sentinel_for<Iter> auto& end, bool operand_size_prefix = false)
+	{
+		const auto read_byte = [&end](Iter& it) -> std::optional<std::uint8_t> {
+			auto byte = convert_bytes<std::uint8_t>(it, end);
+			if (byte)
+				it++;
+			return byte;
+		};
+
+		auto opcode = read_byte(iter);
+		if (!opcode)
+			return std::nullopt;
+
+		// Size of the immediate of cmp/mov r/m, imm32
+		const std::uint8_t immediate_size = operand_size_prefix ? 2 : 4;
+
+		// Expects iter to point at the displacement, the offsets are only used to describe the instruction layout
+		const auto with_displacement = [&](std::uint8_t displacement_offset, std::uint8_t instruction_length) -> std::optional<X86Reference> {
+			auto displacement = convert_bytes<std::int32_t>(iter, end);
+			if (!displacement)
+				return std::nullopt;
+			return X86Reference{
+				.displacement = displacement.value(),
+				.instruction_length = instruction_length,
+				.displacement_offset = displacement_offset,
+			};
+		};
+
+		switch (opcode.value()) {
+		case 0xE8: // call rel32
+		case 0xE9: // jmp rel32
+			return with_displacement(1, 5);
+		case 0x0F: { // jcc rel32
+			auto second = read_byte(iter);
+			if (!second || (second.value() & 0xF0) != 0x80)
+				return std::nullopt;
+			return with_displacement(2, 6);
+		}
+		default:
+			break;
+		}
+
+		// All remaining instructions are of the form opcode ModRM disp32 [imm]
+		auto modrm = read_byte(iter);
+		// mod = 00, r/m = 101 is [rip + disp32] in 64-bit mode
+		if (!modrm || (modrm.value() & 0xC7) != 0x05)
+			return std::nullopt;
+		const std::uint8_t reg = (modrm.value() >> 3) & 0x7;
+
+		switch (opcode.value()) {
+		case 0x38: // cmp r/m8, r8
+		case 0x39: // cmp r/m, r
+		case 0x3A: // cmp r8, r/m8
+		case 0x3B: // cmp r, r/m
+		case 0x88: // mov r/m8, r8
+		case 0x89: // mov r/m, r
+		case 0x8A: // mov r8, r/m8
+		case 0x8B: // mov r, r/m
+		case 0x8D: // lea r, m
+			return with_displacement(2, 6);
+		case 0x80: // cmp r/m8, imm8
+		case 0x83: // cmp r/m, imm8
+			if (reg != 7)
+				return std::nullopt;
+			return with_displacement(2, 7);
+		case 0x81: // cmp r/m, imm32
+			if (reg != 7)
+				return std::nullopt;
+			return with_displacement(2, static_cast<std::uint8_t>(6 + immediate_size));
+		case 0xC6: // mov r/m8, imm8
+			if (reg != 0)
+				return std::nullopt;
+			return with_displacement(2, 7);
+		case 0xC7: // mov r/m, imm32
+			if (reg != 0)
+				return std::nullopt;
+			return with_displacement(2, static_cast<std::uint8_t>(6 + immediate_size));
+		default:
+			return std::nullopt;
+		}
+	}
+}
+
+#endif
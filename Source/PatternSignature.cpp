@@ -1,10 +1,9 @@
 #include "SignatureScanner/PatternSignature.hpp"
-#include "SignatureScanner/detail/PatternParser.hpp"
+#include "SignatureScanner/detail/ApproximateSearch.hpp"
+#include "SignatureScanner/detail/PatternSearch.hpp"
 
-#include <algorithm>
 #include <cstddef>
-#include <iterator>
-#include <memory>
+#include <vector>
 
 // This is the same code, but since this translation unit is optimized these will both run faster as they will be inlined heavily.
 
@@ -12,13 +11,15 @@
 
 FLATTEN const std::byte* SignatureScanner::PatternSignature::optimized_next(const std::byte* begin, const std::byte* end) const
 {
-	return std::ranges::search(begin, end, elements.cbegin(), elements.cend(), detail::pattern_compare<std::byte>).begin();
+	return detail::find_pattern(begin, end, elements);
 }
 
 FLATTEN const std::byte* SignatureScanner::PatternSignature::optimized_prev(const std::byte* begin, const std::byte* end) const
 {
-	auto rbegin = std::make_reverse_iterator(begin);
-	auto rend = std::make_reverse_iterator(end);
-	auto match = std::ranges::search(rbegin, rend, elements.crbegin(), elements.crend(), detail::pattern_compare<std::byte>).end();
-	return std::to_address(match);
+	return detail::find_pattern_reverse(begin, end, elements);
+}
+
+FLATTEN void SignatureScanner::PatternSignature::optimized_approximate(const std::byte* begin, const std::byte* end, std::size_t max_mismatches, std::vector<detail::ApproximateHit>& hits) const
+{
+	detail::find_approximate(begin, end, detail::pack_pattern(elements), max_mismatches, hits);
 }
@@ -10,16 +10,10 @@
 
 FLATTEN const std::byte* SignatureScanner::XRefSignature::optimized_next(const std::byte* it, const std::byte* end, std::uintptr_t location) const
 {
-	for (; it != end; it++)
-		if (does_match(it, end, location++))
-			return it;
-	return it;
+	return search_contiguous(it, end, location);
 }
 
 FLATTEN const std::byte* SignatureScanner::XRefSignature::optimized_prev(const std::byte* it, const std::byte* end, std::uintptr_t location) const
 {
-	for (; it != end; it--)
-		if (does_match(it, end, location--))
-			return it;
-	return it;
+	return search_contiguous_reverse(it, end, location);
 }